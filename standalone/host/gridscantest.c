@@ -0,0 +1,196 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: checks that gridscan() recognizes each game and keeps every
+    row of every grid, including the rows past GRID_MAX_ROWS of the tall
+    multi-grid boards (7-row Dordle, 9-row Quordle, 13-row Octordle).
+
+    usage: gridscantest
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "grid.h"
+#include "gridscan.h"
+
+#define MAX_TEXT 4096
+
+typedef struct
+{
+    const char *name;
+    game_t game;
+    const char *lines[64]; // 'G' / 'Y' / 'B' cells, groups separated by a space; "" separates blocks
+} test_t;
+
+static const test_t tests[] = {
+    {"wordle",
+     GAME_WORDLE,
+     {"Wordle 250 6/6", "", "BBBBB", "BYBBB", "BBGBB", "YBGBB", "BGGGB", "GGGGG", NULL}},
+    {"dordle, 7 rows",
+     GAME_DORDLE,
+     {"Daily Dordle 0123 7&6/7", "", "BBBBB BYBBB", "BYBBB BBBBB", "YBBBB BBGBB", "BGGBB GGGBB", "GGGBB YBBBB",
+      "GGGGG BBBGY", "BBYBB GGGGG", NULL}},
+    {"quordle, 9 rows",
+     GAME_QUORDLE,
+     {"Daily Quordle 123", "", "BBBBB YBBBB", "BYBBB BBBBB", "BBBBB BBGBB", "BBYBB BBBBB", "GGGGG BBBBY",
+      "BBBBB BGBBB", "BBBBB GGGGG", "YYBBB BBBBB", "BBGBB BBBBB", "", "BBBBB BBBBB", "BYBBB BBBBB",
+      "GGGGG BBBBB", "BBBBB GGGGG", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB",
+      NULL}},
+    {"octordle, 13 rows",
+     GAME_OCTORDLE,
+     {"Daily Octordle #1", "", "BBBBB BBBBB", "YBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB",
+      "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB", "BBBBB BBBBB",
+      "GGGGG BYBBB", "", "BBBBB BBBBB", "BBBBB BBBBB", "", "BBBBB BBBBB", "", "YYYYY GGGGG", NULL}},
+};
+
+static const char *glyph(char c)
+{
+    switch (c)
+    {
+    case 'G':
+        return "\xF0\x9F\x9F\xA9"; // 🟩
+    case 'Y':
+        return "\xF0\x9F\x9F\xA8"; // 🟨
+    case 'W':
+        return "\xE2\xAC\x9C"; // ⬜
+    case 'B':
+        return "\xE2\xAC\x9B"; // ⬛
+    default:
+        return NULL;
+    }
+}
+
+// a row of one or two grids: "GYBBB" or "GYBBB BBBBB"
+static int is_row(const char *l)
+{
+    size_t len = strlen(l), i;
+
+    if (len != GRID_COLS && len != 2 * GRID_COLS + 1)
+        return 0;
+    for (i = 0; i < len; i++)
+        if (i == GRID_COLS ? l[i] != ' ' : glyph(l[i]) == NULL)
+            return 0;
+
+    return 1;
+}
+
+// the tweet text: JSON string contents, "\n" escapes separating lines;
+// returns the rows of each grid (blocks of cells only), in gridscan order
+static void build(const test_t *t, char *text, char expect[][GRID_BOARD_MAX_ROWS][GRID_COLS + 1],
+                  int rows[], int *num_grids)
+{
+    int i, block = -1, r = 0, cols, g;
+    const char *l, *gl;
+
+    text[0] = 0;
+    *num_grids = 0;
+    for (i = 0; t->lines[i] != NULL; i++)
+    {
+        l = t->lines[i];
+        if (i > 0)
+            strcat(text, "\\n");
+        if (!is_row(l))
+        {
+            // text line, or a blank line ending the block
+            strcat(text, l);
+            continue;
+        }
+
+        cols = l[GRID_COLS] == ' ' ? 2 : 1;
+        if (i == 0 || !is_row(t->lines[i - 1]))
+        {
+            block++;
+            r = 0;
+            *num_grids = (block + 1) * cols;
+        }
+        for (g = 0; g < cols; g++)
+        {
+            memcpy(expect[block * cols + g][r], l + (GRID_COLS + 1) * g, GRID_COLS);
+            expect[block * cols + g][r][GRID_COLS] = 0;
+            rows[block * cols + g] = r + 1;
+        }
+        for (; *l != 0; l++)
+        {
+            gl = glyph(*l);
+            strcat(text, gl != NULL ? gl : " ");
+        }
+        r++;
+    }
+}
+
+static int run(const test_t *t)
+{
+    static char text[MAX_TEXT];
+    char expect[GRID_BOARD_MAX_GRIDS][GRID_BOARD_MAX_ROWS][GRID_COLS + 1], got[GRID_COLS + 1];
+    int rows[GRID_BOARD_MAX_GRIDS], num_grids, g, r, col, failed = 0;
+    gridscan_t scan;
+    game_t game;
+
+    build(t, text, expect, rows, &num_grids);
+    game = gridscan(text, &scan);
+    if (game != t->game || scan.board.num_grids != num_grids)
+    {
+        printf("FAIL %s: %s with %d grids, expected %s with %d\n", t->name, gridscan_game_name(game),
+               scan.board.num_grids, gridscan_game_name(t->game), num_grids);
+        return 1;
+    }
+
+    for (g = 0; g < num_grids; g++)
+    {
+        if (scan.board.rows[g] != rows[g])
+        {
+            printf("FAIL %s: grid %d has %d rows, expected %d\n", t->name, g, scan.board.rows[g], rows[g]);
+            failed = 1;
+            continue;
+        }
+        for (r = 0; r < rows[g]; r++)
+        {
+            for (col = 0; col < GRID_COLS; col++)
+                got[col] = "BWYG"[grid_board_cell(&scan.board, g, r, col)];
+            got[GRID_COLS] = 0;
+            if (strcmp(got, expect[g][r]) != 0)
+            {
+                printf("FAIL %s: grid %d row %d is %s, expected %s\n", t->name, g, r, got, expect[g][r]);
+                failed = 1;
+            }
+        }
+    }
+
+    // single grids also come as a grid_t
+    if (num_grids == 1)
+    {
+        for (r = 0; r < rows[0]; r++)
+            for (col = 0; col < GRID_COLS; col++)
+                if ("BWYG"[grid_cell(scan.grid, r, col)] != expect[0][r][col])
+                    failed = 1;
+        if (grid_rows(scan.grid) != rows[0] || failed)
+        {
+            printf("FAIL %s: grid_t does not match the board\n", t->name);
+            failed = 1;
+        }
+    }
+
+    if (!failed)
+        printf("ok   %s: %d grid(s), last row of the last grid %s\n", t->name, num_grids,
+               expect[num_grids - 1][rows[num_grids - 1] - 1]);
+    return failed;
+}
+
+int main(void)
+{
+    size_t i;
+    int failed = 0;
+
+    gridscan_init();
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+        failed += run(&tests[i]);
+
+    return failed != 0;
+}
@@ -0,0 +1,18 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: empty stand-in for ESP-IDF's GPIO driver header.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __HOST_GPIO_H__
+#define __HOST_GPIO_H__
+
+#include "esp_err.h"
+
+#endif /* __HOST_GPIO_H__ */
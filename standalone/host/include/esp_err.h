@@ -0,0 +1,40 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: minimal subset of ESP-IDF's esp_err.h.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __ESP_ERR_H__
+#define __ESP_ERR_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+#define ESP_ERROR_CHECK(x)                                                        \
+    do                                                                            \
+    {                                                                             \
+        esp_err_t __err_rc = (x);                                                 \
+        if (__err_rc != ESP_OK)                                                   \
+        {                                                                         \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: 0x%x at %s:%d (%s)\n",       \
+                    __err_rc, __FILE__, __LINE__, #x);                            \
+            abort();                                                              \
+        }                                                                         \
+    } while (0)
+
+#endif /* __ESP_ERR_H__ */
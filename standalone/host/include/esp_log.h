@@ -0,0 +1,41 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: ESP_LOGx macros printing to stderr, so that stdout stays
+    free for the simulated LED matrix.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __ESP_LOG_H__
+#define __ESP_LOG_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// log level threshold: 0 = none, 1 = E, 2 = W, 3 = I, 4 = D, 5 = V
+extern int host_log_level;
+
+uint32_t esp_log_timestamp(void);
+
+#define HOST_LOG(level, letter, tag, format, ...)                                      \
+    do                                                                                 \
+    {                                                                                  \
+        if (host_log_level >= (level))                                                 \
+            fprintf(stderr, letter " (%u) %s: " format "\n", esp_log_timestamp(), tag, \
+                    ##__VA_ARGS__);                                                    \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG(1, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(2, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(3, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(4, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(5, "V", tag, format, ##__VA_ARGS__)
+
+#endif /* __ESP_LOG_H__ */
@@ -0,0 +1,34 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: the led_strip_t interface of ESP-IDF's
+    examples/common_components/led_strip, implemented by led_strip_sim.c.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __HOST_LED_STRIP_H__
+#define __HOST_LED_STRIP_H__
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef struct led_strip_s led_strip_t;
+
+struct led_strip_s
+{
+    esp_err_t (*set_pixel)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+    esp_err_t (*refresh)(led_strip_t *strip, uint32_t timeout_ms);
+    esp_err_t (*clear)(led_strip_t *strip, uint32_t timeout_ms);
+    esp_err_t (*del)(led_strip_t *strip);
+};
+
+led_strip_t *led_strip_init(uint8_t channel, uint8_t gpio, uint16_t led_num);
+esp_err_t led_strip_denit(led_strip_t *strip);
+
+#endif /* __HOST_LED_STRIP_H__ */
@@ -0,0 +1,33 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: stand-in for the sdkconfig.h generated by ESP-IDF.
+    Values mirror the defaults in main/Kconfig.projbuild.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __SDKCONFIG_H__
+#define __SDKCONFIG_H__
+
+#define CONFIG_FREERTOS_HZ 100
+
+#define CONFIG_TWITTER_WORDLE_TAG "wordle"
+#define CONFIG_TWEET_BUF_LEN 1024
+#define CONFIG_JSON_MAX_TOKENS 50
+#define CONFIG_STREAM_BUF_SIZE 1024
+#define CONFIG_STREAM_WAKE_LINGER_MS 20
+
+// (the Makefile passes the LED matrix geometry)
+#ifndef CONFIG_LEDMATRIX_WIDTH
+#define CONFIG_LEDMATRIX_WIDTH 5
+#define CONFIG_LEDMATRIX_HEIGHT 5
+#endif
+#define CONFIG_LEDMATRIX_SCROLL_MS 150
+#define CONFIG_LEDMATRIX_SCROLL_HOLD_MS 1500
+
+#endif /* __SDKCONFIG_H__ */
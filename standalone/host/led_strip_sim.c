@@ -0,0 +1,276 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: simulated WS2812 strip implementing led_strip_t.
+
+    The strip is rendered on an ANSI truecolor terminal and can optionally
+    log every refreshed frame, with a timestamp, to a file. refresh() takes
+    as long as the real strip would: 24 bits at 800 kHz per pixel, followed
+    by the reset (latch) time.
+
+    Environment variables:
+      LEDSIM_ANSI=0|1        render to stdout (default: only if stdout is a tty)
+      LEDSIM_WIDTH=n         pixels per row when rendering/logging (default 5)
+      LEDSIM_GAIN=n          brightness multiplier for the terminal (default 6)
+      LEDSIM_LOG=path        append refreshed frames to path
+      LEDSIM_LOG_FORMAT=fmt  "ppm" (concatenated P6 images) or "rle" (text)
+      LEDSIM_RESET_US=n      latch time in microseconds (default 50, WS2812B-V5: 280)
+      LEDSIM_REALTIME=0|1    model the refresh duration (default 1)
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "led_strip.h"
+#include "esp_log.h"
+#include "port.h"
+#include "led_strip_sim.h"
+
+// WS2812 timing: 1.25 us per bit, 24 bits per pixel
+#define WS2812_PIXEL_NS 30000
+#define WS2812_RESET_US 50
+
+static const char *SIM_TAG = "ledsim";
+
+typedef enum
+{
+    LOG_NONE,
+    LOG_PPM,
+    LOG_RLE,
+} sim_log_format_t;
+
+typedef struct
+{
+    led_strip_t parent;
+    uint16_t led_num;
+    uint8_t *buffer; // RGB triplets, as written by set_pixel()
+
+    int ansi;
+    int ansi_drawn;
+    int width;
+    int gain;
+    int reset_us;
+    int realtime;
+
+    FILE *log;
+    sim_log_format_t log_format;
+
+    uint32_t frames;
+    uint32_t overruns;
+} sim_strip_t;
+
+// most recently created strip, for led_strip_sim_report()
+static sim_strip_t *s_sim;
+
+static int env_int(const char *name, int def)
+{
+    const char *s = getenv(name);
+
+    return (s != NULL && *s != 0) ? atoi(s) : def;
+}
+
+static int64_t sim_refresh_us(sim_strip_t *sim)
+{
+    return ((int64_t)sim->led_num * WS2812_PIXEL_NS) / 1000 + sim->reset_us;
+}
+
+static void sim_draw_ansi(sim_strip_t *sim)
+{
+    int rows = (sim->led_num + sim->width - 1) / sim->width;
+    int i, v;
+    uint8_t *p;
+
+    // redraw in place
+    if (sim->ansi_drawn)
+        printf("\x1b[%dA", rows);
+
+    for (i = 0; i < sim->led_num; i++)
+    {
+        p = sim->buffer + 3 * i;
+        printf("\x1b[48;2");
+        for (v = 0; v < 3; v++)
+            printf(";%d", p[v] * sim->gain > 255 ? 255 : p[v] * sim->gain);
+        printf("m  ");
+
+        if ((i + 1) % sim->width == 0 || i == sim->led_num - 1)
+            printf("\x1b[0m\n");
+    }
+    fflush(stdout);
+    sim->ansi_drawn = 1;
+}
+
+static void sim_log_frame(sim_strip_t *sim, int64_t t_us)
+{
+    int rows = (sim->led_num + sim->width - 1) / sim->width;
+    int i, run;
+    uint8_t *p, *q;
+
+    if (sim->log_format == LOG_PPM)
+    {
+        fprintf(sim->log, "P6\n# t_us=%lld\n%d %d\n255\n", (long long)t_us, sim->width, rows);
+        fwrite(sim->buffer, 3, sim->led_num, sim->log);
+        // pad a partial last row
+        for (i = sim->led_num; i < sim->width * rows; i++)
+            fwrite("\0\0\0", 3, 1, sim->log);
+    }
+    else
+    {
+        // "<t_us> <count>*<rrggbb> ..." one frame per line
+        fprintf(sim->log, "%lld", (long long)t_us);
+        for (i = 0; i < sim->led_num; i += run)
+        {
+            p = sim->buffer + 3 * i;
+            for (run = 1; i + run < sim->led_num; run++)
+            {
+                q = sim->buffer + 3 * (i + run);
+                if (memcmp(p, q, 3) != 0)
+                    break;
+            }
+            fprintf(sim->log, " %d*%02x%02x%02x", run, p[0], p[1], p[2]);
+        }
+        fputc('\n', sim->log);
+    }
+    fflush(sim->log);
+}
+
+static esp_err_t sim_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    sim_strip_t *sim = (sim_strip_t *)strip;
+
+    if (index >= sim->led_num)
+        return ESP_ERR_INVALID_ARG;
+
+    sim->buffer[3 * index + 0] = red & 0xFF;
+    sim->buffer[3 * index + 1] = green & 0xFF;
+    sim->buffer[3 * index + 2] = blue & 0xFF;
+
+    return ESP_OK;
+}
+
+static esp_err_t sim_refresh(led_strip_t *strip, uint32_t timeout_ms)
+{
+    sim_strip_t *sim = (sim_strip_t *)strip;
+    int64_t start = host_time_us();
+    int64_t duration = sim_refresh_us(sim);
+    esp_err_t ret = ESP_OK;
+
+    // the RMT driver gives up waiting after timeout_ms
+    if (duration > (int64_t)timeout_ms * 1000)
+    {
+        duration = (int64_t)timeout_ms * 1000;
+        ret = ESP_ERR_TIMEOUT;
+    }
+
+    sim->frames++;
+    if (sim->ansi)
+        sim_draw_ansi(sim);
+    if (sim->log != NULL)
+        sim_log_frame(sim, start);
+
+    if (sim->realtime)
+    {
+        // terminal or log I/O slower than the wire can't be hidden
+        if (host_time_us() > start + duration)
+            sim->overruns++;
+        host_sleep_until_us(start + duration);
+    }
+
+    return ret;
+}
+
+static esp_err_t sim_clear(led_strip_t *strip, uint32_t timeout_ms)
+{
+    sim_strip_t *sim = (sim_strip_t *)strip;
+
+    memset(sim->buffer, 0, 3 * sim->led_num);
+
+    return sim_refresh(strip, timeout_ms);
+}
+
+void led_strip_sim_report(void)
+{
+    sim_strip_t *sim = s_sim;
+
+    if (sim == NULL)
+        return;
+
+    ESP_LOGI(SIM_TAG, "%u frames, %u overruns of the %lld us refresh time",
+             sim->frames, sim->overruns, (long long)sim_refresh_us(sim));
+}
+
+static esp_err_t sim_del(led_strip_t *strip)
+{
+    sim_strip_t *sim = (sim_strip_t *)strip;
+
+    led_strip_sim_report();
+    if (s_sim == sim)
+        s_sim = NULL;
+
+    if (sim->log != NULL)
+        fclose(sim->log);
+    free(sim->buffer);
+    free(sim);
+
+    return ESP_OK;
+}
+
+led_strip_t *led_strip_init(uint8_t channel, uint8_t gpio, uint16_t led_num)
+{
+    sim_strip_t *sim;
+    const char *path, *format;
+
+    (void)channel;
+    (void)gpio;
+
+    sim = calloc(1, sizeof(sim_strip_t));
+    if (sim == NULL)
+        return NULL;
+    sim->buffer = calloc(led_num, 3);
+    if (sim->buffer == NULL)
+    {
+        free(sim);
+        return NULL;
+    }
+
+    sim->led_num = led_num;
+    sim->ansi = env_int("LEDSIM_ANSI", isatty(STDOUT_FILENO));
+    sim->width = env_int("LEDSIM_WIDTH", 5);
+    sim->gain = env_int("LEDSIM_GAIN", 6);
+    sim->reset_us = env_int("LEDSIM_RESET_US", WS2812_RESET_US);
+    sim->realtime = env_int("LEDSIM_REALTIME", 1);
+    if (sim->width <= 0)
+        sim->width = 5;
+
+    path = getenv("LEDSIM_LOG");
+    if (path != NULL && *path != 0)
+    {
+        format = getenv("LEDSIM_LOG_FORMAT");
+        sim->log_format = (format != NULL && strcmp(format, "rle") == 0) ? LOG_RLE : LOG_PPM;
+        sim->log = fopen(path, sim->log_format == LOG_PPM ? "ab" : "a");
+        if (sim->log == NULL)
+            ESP_LOGE(SIM_TAG, "cannot open frame log %s", path);
+    }
+
+    sim->parent.set_pixel = sim_set_pixel;
+    sim->parent.refresh = sim_refresh;
+    sim->parent.clear = sim_clear;
+    sim->parent.del = sim_del;
+
+    s_sim = sim;
+    ESP_LOGI(SIM_TAG, "%d pixels, refresh takes %lld us", led_num, (long long)sim_refresh_us(sim));
+
+    return &sim->parent;
+}
+
+esp_err_t led_strip_denit(led_strip_t *strip)
+{
+    return strip->del(strip);
+}
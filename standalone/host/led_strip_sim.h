@@ -0,0 +1,21 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: extras of the simulated LED strip.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __LED_STRIP_SIM_H__
+#define __LED_STRIP_SIM_H__
+
+#include "led_strip.h"
+
+// log frame and overrun counts of the most recently created strip
+void led_strip_sim_report(void);
+
+#endif /* __LED_STRIP_SIM_H__ */
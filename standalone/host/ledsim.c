@@ -0,0 +1,139 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: runs ledmatrix.c against the simulated strip and measures
+    the latency of ledmatrix_update() (and ledmatrix_show_board(), with -b).
+
+    usage: ledsim [-n updates] [-p period_ms] [-b] [-q]
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "ledmatrix.h"
+#include "esp_log.h"
+#include "port.h"
+#include "led_strip_sim.h"
+
+const char *TAG = "wordle";
+
+// sample solutions, encoded as gridscan() does
+static const char *grids[] = {
+    "GGGGG",
+    "BYBBBBGYBGGGGGG",
+    "BBBYBYGBBBBGGBGGGGGG",
+    "WWYWWWGWYWGGWWGGGGWGGGGGG",
+    "BBBBBBYBBYBBGBYGGGGG",
+    "BBBBBBYBBYBBGBYBGGBYGGGBYGGGGG", // (6 lines: scrolled)
+};
+
+// a 9-row Quordle (-b: every 4th update), grids left to right, then top to bottom
+static const char *quordle[] = {
+    "BBBBBBYBBBBBBBBBBYBBGGGGGBBBBBBBBBBBBBBBBBBBB",
+    "YBBBBBBBBBBBGBBBBBBBBBBBYBGBBBGGGGGBBBBBBBBBB",
+    "BBBBBBYBBBBBBBBYYBBBBBBBBBBBBBBBBBBGGGGGBBBBB",
+    "BBBBBBBBBBBBBBBBBBBBBBBBBBBGBBBBBBBBBBBBGGGGG",
+};
+
+// one 10-bit word per row, as gridscan() builds it
+static void board_encode(grid_board_t *board)
+{
+    int g, r, c, cell;
+
+    memset(board, 0, sizeof(*board));
+    board->num_grids = sizeof(quordle) / sizeof(quordle[0]);
+    board->cols = 2;
+    for (g = 0; g < board->num_grids; g++)
+    {
+        board->rows[g] = strlen(quordle[g]) / GRID_COLS;
+        for (r = 0; r < board->rows[g]; r++)
+        {
+            for (c = 0; c < GRID_COLS; c++)
+            {
+                cell = strchr("BWYG", quordle[g][r * GRID_COLS + c]) - "BWYG";
+                board->cells[g][r] |= cell << (2 * c);
+            }
+        }
+    }
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    int n = 100, period_ms = 0, boards = 0;
+    int64_t *lat, t0, sum = 0;
+    grid_board_t board;
+    int i, opt;
+
+    while ((opt = getopt(argc, argv, "n:p:bq")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            n = atoi(optarg);
+            break;
+        case 'p':
+            period_ms = atoi(optarg);
+            break;
+        case 'b':
+            boards = 1;
+            break;
+        case 'q':
+            host_log_level = 2;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n updates] [-p period_ms] [-b] [-q]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n <= 0)
+        n = 1;
+
+    lat = calloc(n, sizeof(int64_t));
+    if (lat == NULL)
+        return 1;
+
+    ledmatrix_init();
+    board_encode(&board);
+
+    for (i = 0; i < n; i++)
+    {
+        const char *g = grids[i % (sizeof(grids) / sizeof(grids[0]))];
+        grid_t grid = grid_encode(g, strlen(g) / 5);
+
+        t0 = host_time_us();
+        if (boards && i % 4 == 3)
+            ledmatrix_show_board(&board);
+        else
+            ledmatrix_update(grid);
+        lat[i] = host_time_us() - t0;
+        sum += lat[i];
+
+        if (period_ms > 0)
+            host_sleep_until_us(t0 + (int64_t)period_ms * 1000);
+    }
+
+    qsort(lat, n, sizeof(int64_t), cmp_i64);
+    fprintf(stderr, "%s: %d calls, min %lld us, mean %lld us, p50 %lld us, p99 %lld us, max %lld us\n",
+            boards ? "ledmatrix_update / ledmatrix_show_board" : "ledmatrix_update", n, (long long)lat[0], (long long)(sum / n), (long long)lat[n / 2],
+            (long long)lat[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1], (long long)lat[n - 1]);
+    led_strip_sim_report();
+
+    free(lat);
+    return 0;
+}
@@ -0,0 +1,318 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: POSIX implementation of the ESP-IDF / FreeRTOS calls
+    declared in include/.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <time.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "port.h"
+
+int host_log_level = 3;
+
+static int64_t s_start_us;
+
+int64_t host_time_us(void)
+{
+    struct timespec ts;
+    int64_t now;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    if (s_start_us == 0)
+        s_start_us = now;
+
+    return now - s_start_us;
+}
+
+void host_sleep_until_us(int64_t deadline_us)
+{
+    int64_t now = host_time_us();
+    struct timespec ts;
+
+    // sleep coarsely, then spin for the last stretch so short waits stay accurate
+    if (deadline_us - now > 200)
+    {
+        int64_t delta = deadline_us - now - 100;
+        ts.tv_sec = delta / 1000000;
+        ts.tv_nsec = (delta % 1000000) * 1000;
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+            ;
+    }
+    while (host_time_us() < deadline_us)
+        ;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_sleep_until_us(host_time_us() + (int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(host_time_us() / (portTICK_PERIOD_MS * 1000));
+}
+
+struct host_task
+{
+    TaskFunction_t fn;
+    void *arg;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t value;
+    int pending;
+};
+
+static __thread TaskHandle_t s_current_task;
+
+static void *task_thread(void *arg)
+{
+    TaskHandle_t task = arg;
+
+    s_current_task = task;
+    task->fn(task->arg);
+
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                       UBaseType_t priority, TaskHandle_t *out_handle)
+{
+    TaskHandle_t task = calloc(1, sizeof(struct host_task));
+
+    if (task == NULL)
+        return pdFAIL;
+
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_init(&task->mutex, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    // (the handle is set before the task can run, as on the device)
+    if (out_handle != NULL)
+        *out_handle = task;
+    if (pthread_create(&task->thread, NULL, task_thread, task) != 0)
+    {
+        if (out_handle != NULL)
+            *out_handle = NULL;
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+
+    return pdPASS;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    pthread_mutex_lock(&task->mutex);
+    task->value |= value;
+    task->pending = 1;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks)
+{
+    TaskHandle_t task = s_current_task;
+    struct timespec ts;
+    int ret = 0;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+    ts.tv_sec += ticks / configTICK_RATE_HZ + ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %= 1000000000L;
+
+    pthread_mutex_lock(&task->mutex);
+    if (!task->pending)
+        task->value &= ~clear_on_entry;
+    while (!task->pending && ret == 0 && ticks != 0)
+    {
+        if (ticks == portMAX_DELAY)
+            ret = pthread_cond_wait(&task->cond, &task->mutex);
+        else
+            ret = pthread_cond_timedwait(&task->cond, &task->mutex, &ts);
+    }
+    ret = task->pending;
+    if (value != NULL)
+        *value = task->value;
+    if (ret)
+    {
+        task->value &= ~clear_on_exit;
+        task->pending = 0;
+    }
+    pthread_mutex_unlock(&task->mutex);
+
+    return ret ? pdTRUE : pdFALSE;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(host_time_us() / 1000);
+}
+
+// a mutex is a binary semaphore created full (no priority inheritance on the host)
+struct host_semaphore
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int count;
+};
+
+static SemaphoreHandle_t semaphore_create(int count)
+{
+    SemaphoreHandle_t sem = malloc(sizeof(struct host_semaphore));
+
+    if (sem != NULL)
+    {
+        pthread_mutex_init(&sem->mutex, NULL);
+        pthread_cond_init(&sem->cond, NULL);
+        sem->count = count;
+    }
+
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return semaphore_create(1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return semaphore_create(0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec ts;
+    int ret = 0;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+    ts.tv_sec += ticks / configTICK_RATE_HZ + ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %= 1000000000L;
+
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0 && ret == 0 && ticks != 0)
+    {
+        if (ticks == portMAX_DELAY)
+            ret = pthread_cond_wait(&sem->cond, &sem->mutex);
+        else
+            ret = pthread_cond_timedwait(&sem->cond, &sem->mutex, &ts);
+    }
+    ret = sem->count > 0;
+    if (ret)
+        sem->count = 0;
+    pthread_mutex_unlock(&sem->mutex);
+
+    return ret ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    int given;
+
+    pthread_mutex_lock(&sem->mutex);
+    given = sem->count == 0;
+    sem->count = 1;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+
+    return given ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return host_time_us();
+}
+
+// periodic timers run their callback on a thread of their own
+struct host_timer
+{
+    esp_timer_create_args_t args;
+    pthread_t thread;
+    int64_t period_us;
+    volatile int running;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    esp_timer_handle_t timer = calloc(1, sizeof(struct host_timer));
+
+    if (timer == NULL)
+        return ESP_ERR_NO_MEM;
+
+    timer->args = *args;
+    *out_handle = timer;
+
+    return ESP_OK;
+}
+
+static void *timer_thread(void *arg)
+{
+    esp_timer_handle_t timer = arg;
+    int64_t next = host_time_us() + timer->period_us;
+
+    while (timer->running)
+    {
+        host_sleep_until_us(next);
+        if (!timer->running)
+            break;
+        timer->args.callback(timer->args.arg);
+        next += timer->period_us;
+    }
+
+    return NULL;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (timer->running)
+        return ESP_ERR_INVALID_STATE;
+
+    timer->period_us = period_us;
+    timer->running = 1;
+    if (pthread_create(&timer->thread, NULL, timer_thread, timer) != 0)
+    {
+        timer->running = 0;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->running)
+        return ESP_ERR_INVALID_STATE;
+
+    timer->running = 0;
+    pthread_join(timer->thread, NULL);
+
+    return ESP_OK;
+}
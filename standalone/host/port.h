@@ -0,0 +1,24 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: helpers shared by the host port and tools.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __HOST_PORT_H__
+#define __HOST_PORT_H__
+
+#include <stdint.h>
+
+// monotonic time in microseconds since the first call
+int64_t host_time_us(void);
+
+// sleep until host_time_us() reaches the deadline (spins for the last ~100 us)
+void host_sleep_until_us(int64_t deadline_us);
+
+#endif /* __HOST_PORT_H__ */
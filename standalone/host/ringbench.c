@@ -0,0 +1,287 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: feeds a synthetic record stream, chopped into TLS-read-sized
+    fragments, from a producer thread to a consumer thread that frames
+    records, through either bytering.c or a model of a FreeRTOS stream
+    buffer with trigger level 1. Reports throughput, consumer receives per
+    record and framing latency, and checks that every byte arrived in order
+    and, in newline mode, that every record fitting the buffers arrived whole.
+
+    usage: ringbench [-m stream|bytes|newline] [-n records] [-s ring_size]
+                     [-w wake_bytes] [-f max_fragment] [-d fragment_delay_us]
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "bytering.h"
+#include "port.h"
+
+// same size as the parser's record buffer
+#define RECV_BUF_LEN 1024
+
+enum
+{
+    MODE_STREAM,
+    MODE_BYTES,
+    MODE_NEWLINE,
+};
+
+static int mode = MODE_NEWLINE;
+static int num_records = 20000;
+static size_t ring_size = 1024;
+static size_t wake_bytes = 256;
+static int max_fragment = 512;
+static int fragment_delay_us = 0;
+
+static char *stream;          // all records back to back
+static size_t stream_len;
+static size_t *record_end;    // offset just past each record's '\n'
+static int64_t *committed_us; // when each record's last byte was sent
+static int64_t *framed_us;    // when the consumer saw it
+
+// model of a FreeRTOS stream buffer: one lock, receiver woken on every send
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t data, space;
+    uint8_t *buf;
+    size_t size, head, tail;
+} sbuf_t;
+
+static sbuf_t sbuf;
+static bytering_t *ring;
+
+static size_t sbuf_send(const uint8_t *data, size_t len)
+{
+    size_t n, i;
+
+    pthread_mutex_lock(&sbuf.mutex);
+    while (sbuf.head - sbuf.tail == sbuf.size)
+        pthread_cond_wait(&sbuf.space, &sbuf.mutex);
+    n = sbuf.size - (sbuf.head - sbuf.tail);
+    if (n > len)
+        n = len;
+    for (i = 0; i < n; i++)
+        sbuf.buf[(sbuf.head + i) % sbuf.size] = data[i];
+    sbuf.head += n;
+    pthread_cond_signal(&sbuf.data);
+    pthread_mutex_unlock(&sbuf.mutex);
+
+    return n;
+}
+
+static size_t sbuf_receive(uint8_t *data, size_t len)
+{
+    size_t n, i;
+
+    pthread_mutex_lock(&sbuf.mutex);
+    while (sbuf.head == sbuf.tail)
+        pthread_cond_wait(&sbuf.data, &sbuf.mutex);
+    n = sbuf.head - sbuf.tail;
+    if (n > len)
+        n = len;
+    for (i = 0; i < n; i++)
+        data[i] = sbuf.buf[(sbuf.tail + i) % sbuf.size];
+    sbuf.tail += n;
+    pthread_cond_signal(&sbuf.space);
+    pthread_mutex_unlock(&sbuf.mutex);
+
+    return n;
+}
+
+static void make_stream(void)
+{
+    static const char *rows[] = {"\\u2b1b\\u2b1b\\ud83d\\udfe8\\u2b1b\\u2b1b",
+                                 "\\ud83d\\udfe9\\u2b1b\\ud83d\\udfe8\\u2b1b\\u2b1b",
+                                 "\\ud83d\\udfe9\\ud83d\\udfe9\\ud83d\\udfe9\\ud83d\\udfe9\\ud83d\\udfe9"};
+    size_t cap = (size_t)num_records * 768, len = 0;
+    int i, j;
+
+    stream = malloc(cap);
+    record_end = malloc(num_records * sizeof(size_t));
+    committed_us = calloc(num_records, sizeof(int64_t));
+    framed_us = calloc(num_records, sizeof(int64_t));
+    if (stream == NULL || record_end == NULL || committed_us == NULL || framed_us == NULL)
+        exit(1);
+
+    srand(1);
+    for (i = 0; i < num_records; i++)
+    {
+        len += sprintf(stream + len, "{\"data\":{\"id\":\"%d\",\"text\":\"Wordle %d %d/6", 1500000000 + i, 200 + i % 300,
+                       i % 5 + 1);
+        for (j = i % 5; j >= 0; j--)
+            len += sprintf(stream + len, "\\n%s", rows[j > 2 ? 1 : 2 - j]);
+        len += sprintf(stream + len, "\"},\"matching_rules\":[{\"id\":\"1489000000000000%03d\",\"tag\":\"wordle\"}]}\r\n",
+                       i % 1000);
+        record_end[i] = len;
+    }
+    stream_len = len;
+}
+
+static void *producer(void *arg)
+{
+    size_t pos = 0, frag, sent;
+    int rec = 0;
+
+    while (pos < stream_len)
+    {
+        frag = 1 + rand() % max_fragment;
+        if (frag > stream_len - pos)
+            frag = stream_len - pos;
+
+        for (sent = 0; sent < frag;)
+        {
+            if (mode == MODE_STREAM)
+                sent += sbuf_send((uint8_t *)stream + pos + sent, frag - sent);
+            else
+                sent += bytering_send(ring, stream + pos + sent, frag - sent, portMAX_DELAY);
+        }
+        pos += frag;
+
+        // (timestamps are taken after the send, so latency is slightly underestimated)
+        for (; rec < num_records && record_end[rec] <= pos; rec++)
+            committed_us[rec] = host_time_us();
+
+        if (fragment_delay_us > 0)
+            host_sleep_until_us(host_time_us() + fragment_delay_us);
+    }
+
+    return NULL;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t buf[RECV_BUF_LEN];
+    pthread_t thread;
+    size_t pos = 0, n, i;
+    long receives = 0, partial = 0, split = 0;
+    int rec = 0, errors = 0, opt;
+    int64_t t0, t1;
+
+    while ((opt = getopt(argc, argv, "m:n:s:w:f:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            mode = !strcmp(optarg, "stream") ? MODE_STREAM : !strcmp(optarg, "bytes") ? MODE_BYTES : MODE_NEWLINE;
+            break;
+        case 'n':
+            num_records = atoi(optarg);
+            break;
+        case 's':
+            ring_size = atoi(optarg);
+            break;
+        case 'w':
+            wake_bytes = atoi(optarg);
+            break;
+        case 'f':
+            max_fragment = atoi(optarg);
+            break;
+        case 'd':
+            fragment_delay_us = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-m stream|bytes|newline] [-n records] [-s ring_size] "
+                            "[-w wake_bytes] [-f max_fragment] [-d fragment_delay_us]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (num_records <= 0 || ring_size == 0 || max_fragment <= 0)
+        return 1;
+
+    make_stream();
+
+    if (mode == MODE_STREAM)
+    {
+        pthread_mutex_init(&sbuf.mutex, NULL);
+        pthread_cond_init(&sbuf.data, NULL);
+        pthread_cond_init(&sbuf.space, NULL);
+        sbuf.buf = malloc(ring_size);
+        sbuf.size = ring_size;
+    }
+    else
+    {
+        ring = bytering_create(ring_size, mode == MODE_BYTES ? BYTERING_WAKE_BYTES : BYTERING_WAKE_NEWLINE,
+                               wake_bytes, pdMS_TO_TICKS(20));
+        if (ring == NULL)
+            return 1;
+    }
+
+    t0 = host_time_us();
+    pthread_create(&thread, NULL, producer, NULL);
+
+    // consume, checking the bytes and timestamping every record boundary
+    while (pos < stream_len)
+    {
+        if (mode == MODE_STREAM)
+            n = sbuf_receive(buf, sizeof(buf));
+        else
+            n = bytering_receive(ring, buf, sizeof(buf), portMAX_DELAY);
+        receives++;
+        if (n > 0 && buf[n - 1] != '\n')
+            partial++;
+
+        if (memcmp(buf, stream + pos, n) != 0)
+            errors++;
+        for (i = 0; i < n; i++)
+        {
+            if (buf[i] == '\n')
+            {
+                if (rec < num_records && pos + i + 1 == record_end[rec])
+                    framed_us[rec++] = host_time_us();
+                else
+                    errors++;
+            }
+        }
+        pos += n;
+
+        // in newline mode a record that fits both the ring and the receive
+        // buffer must arrive whole (only longer ones may be split)
+        if (mode == MODE_NEWLINE && n > 0 && buf[n - 1] != '\n' && rec < num_records &&
+            record_end[rec] - (rec > 0 ? record_end[rec - 1] : 0) <= (ring_size < sizeof(buf) ? ring_size : sizeof(buf)))
+            split++;
+    }
+    t1 = host_time_us();
+    pthread_join(thread, NULL);
+
+    for (i = 0; i < (size_t)num_records; i++)
+        framed_us[i] = framed_us[i] > committed_us[i] ? framed_us[i] - committed_us[i] : 0;
+    qsort(framed_us, num_records, sizeof(int64_t), cmp_i64);
+
+    printf("%s: %d records, %zu bytes in %.1f ms (%.1f MB/s)\n",
+           mode == MODE_STREAM ? "stream buffer" : mode == MODE_BYTES ? "bytering, byte threshold" : "bytering, newline",
+           num_records, stream_len, (t1 - t0) / 1000.0, stream_len / (double)(t1 - t0));
+    printf("receives: %ld (%.2f per record, %ld ending mid-record)", receives, receives / (double)num_records, partial);
+    if (ring != NULL)
+        printf(", consumer wakeups %u (%.2f per record)", atomic_load(&ring->wakeups),
+               atomic_load(&ring->wakeups) / (double)num_records);
+    printf("\nframing latency (us): p50 %lld, p99 %lld, max %lld\n", (long long)framed_us[num_records / 2],
+           (long long)framed_us[num_records * 99 / 100], (long long)framed_us[num_records - 1]);
+    if (errors || rec != num_records)
+        printf("FAILED: stream corrupted\n");
+    else if (split)
+        printf("FAILED: %ld records split across receives\n", split);
+    else
+        printf("stream intact, records whole\n");
+
+    return errors || rec != num_records || split;
+}
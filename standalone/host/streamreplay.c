@@ -0,0 +1,353 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: replays a raw stream capture (see main/capture.h) through the
+    firmware's stream ring and parser steps. A producer thread commits every
+    captured chunk to bytering.c as the stream task did, with the same read
+    boundaries and at the same times; the main thread frames and parses the
+    records like the parser task (lwjson, tweet.c, gridscan.c). The same
+    capture always gives the same input, so slowdowns seen on the device can
+    be reproduced and measured.
+
+    usage: streamreplay [-f | -x speed] [-s ring_size] capture.log|capture.bin
+
+    The capture is either a console log with "CAPTURE:" lines or a dump of the
+    "capture" partition, e.g. from parttool.py read_partition. With -f the
+    chunks are sent as fast as the ring takes them, -x scales the timing.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sdkconfig.h"
+#include "bytering.h"
+#include "capture.h"
+#include "gridscan.h"
+#include "tweet.h"
+#include "port.h"
+
+#define TWEET_BUF_LEN CONFIG_TWEET_BUF_LEN
+
+typedef struct
+{
+    capture_chunk_t hdr;
+    const uint8_t *data;
+    size_t end; // stream offset just past the chunk
+} chunk_t;
+
+static chunk_t *chunks;
+static int num_chunks, connections, missing;
+static size_t stream_len;
+static int64_t *committed_us; // when each chunk started to be committed
+
+static bytering_t *ring;
+static double speed = 1.0; // 0: as fast as possible
+
+static int b64_value(int c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    return c == '+' ? 62 : c == '/' ? 63 : -1;
+}
+
+// decodes in place, stops at the first character that isn't base64
+static size_t b64_decode(char *s)
+{
+    uint8_t *out = (uint8_t *)s;
+    uint32_t acc = 0;
+    int bits = 0, v;
+    size_t n = 0;
+
+    for (; (v = b64_value((unsigned char)*s)) >= 0; s++)
+    {
+        acc = acc << 6 | v;
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            out[n++] = acc >> bits;
+        }
+    }
+
+    return n;
+}
+
+static void add_chunk(const capture_chunk_t *hdr, const uint8_t *data)
+{
+    static int cap;
+    static uint16_t next_seq;
+
+    if (num_chunks == cap)
+    {
+        cap = cap ? 2 * cap : 4096;
+        chunks = realloc(chunks, cap * sizeof(chunk_t));
+        if (chunks == NULL)
+            exit(1);
+    }
+    if (num_chunks > 0)
+        missing += (uint16_t)(hdr->seq - next_seq);
+    next_seq = hdr->seq + 1;
+
+    if (hdr->len == 0)
+        connections++;
+    stream_len += hdr->len;
+    chunks[num_chunks].hdr = *hdr;
+    chunks[num_chunks].data = data;
+    chunks[num_chunks].end = stream_len;
+    num_chunks++;
+}
+
+// the chunks point into buf, which is kept
+static int load(char *buf, size_t len)
+{
+    const capture_header_t *header = (const capture_header_t *)buf;
+    capture_chunk_t hdr;
+    size_t pos, n;
+    char *line, *p;
+
+    // partition dump
+    if (len >= sizeof(capture_header_t) && memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) == 0)
+    {
+        if (header->version != CAPTURE_VERSION || header->chunk_size != sizeof(capture_chunk_t))
+            return -1;
+        for (pos = sizeof(capture_header_t); pos + sizeof(hdr) <= len; pos += sizeof(hdr) + hdr.len)
+        {
+            memcpy(&hdr, buf + pos, sizeof(hdr));
+            if (hdr.len == 0xffff || pos + sizeof(hdr) + hdr.len > len)
+                break;
+            add_chunk(&hdr, (uint8_t *)buf + pos + sizeof(hdr));
+        }
+        return 0;
+    }
+
+    // console log: one chunk per line, possibly among other output
+    buf[len - 1] = 0;
+    for (line = strtok(buf, "\n"); line != NULL; line = strtok(NULL, "\n"))
+    {
+        if ((p = strstr(line, "CAPTURE:")) == NULL)
+            continue;
+        p += strlen("CAPTURE:");
+        n = b64_decode(p);
+        if (n < sizeof(hdr))
+            continue;
+        memcpy(&hdr, p, sizeof(hdr));
+        if (sizeof(hdr) + hdr.len != n)
+        {
+            fprintf(stderr, "skipping a truncated chunk (seq %u)\n", hdr.seq);
+            continue;
+        }
+        add_chunk(&hdr, (uint8_t *)p + sizeof(hdr));
+    }
+
+    return 0;
+}
+
+// the stream task's side: the captured chunks at their times, reserved and
+// committed as it does (the split into commits depends on the ring's room)
+static void *producer(void *arg)
+{
+    int64_t due = host_time_us();
+    size_t done, n;
+    uint8_t *span;
+    int i;
+
+    for (i = 0; i < num_chunks; i++)
+    {
+        const chunk_t *c = &chunks[i];
+
+        if (speed > 0)
+        {
+            due += c->hdr.delta_us / speed;
+            host_sleep_until_us(due);
+        }
+        for (done = 0; done < c->hdr.len; done += n)
+        {
+            n = bytering_reserve_wait(ring, &span, portMAX_DELAY);
+            if (n > c->hdr.len - done)
+                n = c->hdr.len - done;
+            memcpy(span, c->data + done, n);
+            if (done == 0)
+                committed_us[i] = host_time_us();
+            bytering_commit(ring, n);
+        }
+    }
+
+    return NULL;
+}
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void print_latency(const char *label, int64_t *us, int n)
+{
+    if (n == 0)
+        return;
+    qsort(us, n, sizeof(int64_t), cmp_i64);
+    printf("%s (us): p50 %lld, p99 %lld, max %lld\n", label, (long long)us[n / 2], (long long)us[n * 99 / 100],
+           (long long)us[n - 1]);
+}
+
+int main(int argc, char **argv)
+{
+    static char buf[TWEET_BUF_LEN];
+    static lwjson_token_t tokens[CONFIG_JSON_MAX_TOKENS];
+    size_t ring_size = CONFIG_STREAM_BUF_SIZE, pos = 0, size;
+    long games[GAME_NUM] = {0}, records = 0, too_long = 0, json_failed = 0, untagged = 0, no_grid = 0;
+    int64_t *latency_us, *parse_us, t0, t1, capture_us = 0;
+    int i, c = 0, opt, len, held = 0, skipping = 0;
+    char *tweet_buf, *p, *data, *text;
+    gridscan_t scan;
+    game_t game;
+    lwjson_t json;
+    pthread_t thread;
+    FILE *f;
+
+    while ((opt = getopt(argc, argv, "fx:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            speed = 0;
+            break;
+        case 'x':
+            speed = atof(optarg);
+            break;
+        case 's':
+            ring_size = atoi(optarg);
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc - 1 || speed < 0 || ring_size == 0)
+    {
+        fprintf(stderr, "usage: %s [-f | -x speed] [-s ring_size] capture.log|capture.bin\n", argv[0]);
+        return 1;
+    }
+
+    f = fopen(argv[optind], "rb");
+    if (f == NULL)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    rewind(f);
+    data = malloc(size + 1);
+    if (data == NULL || fread(data, 1, size, f) != size)
+        return 1;
+    fclose(f);
+    data[size++] = '\n';
+    if (load(data, size) < 0 || num_chunks == 0)
+    {
+        fprintf(stderr, "%s: no capture found\n", argv[optind]);
+        return 1;
+    }
+    for (i = 0; i < num_chunks; i++)
+        capture_us += chunks[i].hdr.delta_us;
+
+    committed_us = calloc(num_chunks, sizeof(int64_t));
+    latency_us = malloc((stream_len / 2 + 1) * sizeof(int64_t));
+    parse_us = malloc((stream_len / 2 + 1) * sizeof(int64_t));
+    ring = bytering_create(ring_size, BYTERING_WAKE_NEWLINE, 0, pdMS_TO_TICKS(CONFIG_STREAM_WAKE_LINGER_MS));
+    if (committed_us == NULL || latency_us == NULL || parse_us == NULL || ring == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    gridscan_init();
+    lwjson_init(&json, tokens, LWJSON_ARRAYSIZE(tokens));
+
+    t0 = host_time_us();
+    pthread_create(&thread, NULL, producer, NULL);
+
+    // the parser task's loop
+    while (pos < stream_len)
+    {
+        len = bytering_receive(ring, buf + held, TWEET_BUF_LEN - 1 - held, portMAX_DELAY);
+        if (len == 0)
+            continue;
+        pos += len;
+        len += held;
+        buf[len] = 0;
+
+        // the chunk that brought the last byte received
+        while (c < num_chunks - 1 && chunks[c].end < pos)
+            c++;
+
+        tweet_buf = buf;
+        while ((p = strchr(tweet_buf, '\n')) != NULL)
+        {
+            *p = 0;
+
+            if (tweet_buf[0] == '{' && !skipping)
+            {
+                int64_t s0 = host_time_us();
+
+                latency_us[records] = s0 - committed_us[c];
+                if (lwjson_parse(&json, tweet_buf) != lwjsonOK)
+                    json_failed++;
+                else if (!tweet_tagged(&json, CONFIG_TWITTER_WORDLE_TAG))
+                    untagged++;
+                else if ((text = tweet_text(&json)) == NULL || (game = gridscan(text, &scan)) == GAME_NONE)
+                    no_grid++;
+                else
+                    games[game]++;
+                parse_us[records++] = host_time_us() - s0;
+            }
+            skipping = 0;
+            tweet_buf = p + 1;
+        }
+
+        // keep the start of the next record, unless it can't fit the buffer
+        held = buf + len - tweet_buf;
+        if (held == TWEET_BUF_LEN - 1)
+        {
+            // (once per record, however many buffers it takes to skip)
+            if (!skipping)
+                too_long++;
+            skipping = 1;
+            held = 0;
+        }
+        else
+            memmove(buf, tweet_buf, held);
+    }
+    t1 = host_time_us();
+    pthread_join(thread, NULL);
+
+    printf("%d chunks, %d connections, %d chunks missing, %zu bytes over %.3f s of capture\n", num_chunks,
+           connections, missing, stream_len, capture_us / 1e6);
+    printf("replayed in %.3f s (%s), consumer wakeups %u\n", (t1 - t0) / 1e6, speed > 0 ? "timed" : "as fast as possible",
+           atomic_load(&ring->wakeups));
+    printf("%ld records: %ld too long, %ld JSON errors, %ld not tagged, %ld without grids\n", records, too_long,
+           json_failed, untagged, no_grid);
+    for (i = GAME_NONE + 1; i < GAME_NUM; i++)
+    {
+        if (games[i] > 0)
+            printf("%-10s %ld\n", gridscan_game_name(i), games[i]);
+    }
+    print_latency("chunk committed to record framed", latency_us, records);
+    print_latency("record parse and match", parse_us, records);
+
+    return 0;
+}
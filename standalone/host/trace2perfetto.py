@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Convert a Wordle device trace dump to Chrome trace / Perfetto JSON.
+
+The input is either a console log containing "TRACE:" lines (as written by
+trace_dump() after a slow record) or the raw binary served at /trace by the
+status server. With several dumps in a log, the last one is converted.
+
+usage: trace2perfetto.py <log-or-dump> [out.json]
+
+Open the result in https://ui.perfetto.dev or chrome://tracing.
+"""
+
+import base64
+import json
+import struct
+import sys
+
+MAGIC = b"WTRC"
+HEADER = struct.Struct("<4sHHI")
+EVENT = struct.Struct("<IHBB")
+
+# must match trace_stage_t in main/trace.h
+STAGES = ["tls_read", "frame", "lwjson_parse", "tagged_wordle", "check_wordle",
+          "ledmatrix_update", "refresh"]
+# one track per task
+TRACKS = {"tls_read": 1, "frame": 2, "lwjson_parse": 2, "tagged_wordle": 2,
+          "check_wordle": 2, "ledmatrix_update": 3, "refresh": 3}
+TRACK_NAMES = {1: "https_stream_task", 2: "parser", 3: "renderer"}
+PHASES = ["B", "E", "i"]
+
+
+def extract_dumps(data):
+    """Return the binary dumps contained in a console log or raw file."""
+    if data.startswith(MAGIC):
+        return [data]
+
+    dumps, cur = [], None
+    for line in data.decode("utf-8", "replace").splitlines():
+        line = line.strip()
+        if line.startswith("TRACE BEGIN"):
+            cur = []
+        elif line.startswith("TRACE END") and cur is not None:
+            dumps.append(base64.b64decode("".join(cur)))
+            cur = None
+        elif line.startswith("TRACE:") and cur is not None:
+            cur.append(line[len("TRACE:"):])
+    return dumps
+
+
+def decode(dump):
+    magic, version, event_size, count = HEADER.unpack_from(dump, 0)
+    if magic != MAGIC or version != 1 or event_size != EVENT.size:
+        raise ValueError("not a version 1 trace dump")
+
+    events, offset, last, wraps = [], HEADER.size, None, 0
+    for i in range(count):
+        ts, record, stage, phase = EVENT.unpack_from(dump, offset + i * EVENT.size)
+        # timestamps are 32-bit microseconds, unwrap them
+        if last is not None and ts < last and last - ts > 1 << 31:
+            wraps += 1
+        last = ts
+        events.append((ts + (wraps << 32), record, stage, phase))
+    return events
+
+
+def to_chrome(events):
+    out = []
+    for tid, name in TRACK_NAMES.items():
+        out.append({"ph": "M", "pid": 1, "tid": tid, "name": "thread_name",
+                    "args": {"name": name}})
+
+    for ts, record, stage, phase in events:
+        name = STAGES[stage] if stage < len(STAGES) else "stage%d" % stage
+        ev = {"name": name, "ph": PHASES[phase] if phase < len(PHASES) else "i",
+              "ts": ts, "pid": 1, "tid": TRACKS.get(name, 4)}
+        if name == "tls_read":
+            ev["args"] = {"bytes": record}
+        else:
+            ev["args"] = {"record": record}
+        if ev["ph"] == "i":
+            ev["s"] = "t"
+        out.append(ev)
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+def main(argv):
+    args = argv[1:]
+    if not args:
+        print(__doc__, file=sys.stderr)
+        return 1
+
+    with open(args[0], "rb") as f:
+        dumps = extract_dumps(f.read())
+    if not dumps:
+        print("no trace dump found", file=sys.stderr)
+        return 1
+
+    events = decode(dumps[-1])
+    trace = to_chrome(events)
+    out = open(args[1], "w") if len(args) > 1 else sys.stdout
+    json.dump(trace, out)
+    print("%d events" % len(events), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
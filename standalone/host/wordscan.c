@@ -0,0 +1,378 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: runs the parser's extraction over archived filtered-stream
+    records (one JSON record per line) and reports what the device would have
+    found in them. Each archive is memory-mapped and cut into one range per
+    thread at line boundaries; every thread parses its records with its own
+    lwjson instance, applies the same checks as the parser task (tweet.c,
+    gridscan.c) and keeps its own counters, which are added up at the end.
+
+    usage: wordscan [-j threads] [-b record_len] [-k tokens] [-t tag] archive.jsonl...
+
+    Records longer than record_len (default: the firmware's TWEET_BUF_LEN) or
+    with more than the given number of JSON tokens (default: JSON_MAX_TOKENS)
+    are counted as failures, like on the device; raise the limits to see past
+    them. The throughput in GB/s tells whether the scan is bound by the parser
+    or by reading the archive.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sdkconfig.h"
+#include "grid.h"
+#include "gridscan.h"
+#include "tweet.h"
+#include "port.h"
+
+// what the threads count, added up at the end
+typedef struct
+{
+    long records;
+    long too_long;
+    long json_failed;
+    long untagged;
+    long no_text;
+    long not_grid;
+    long games[GAME_NUM];
+    long high_contrast;
+    long unsolved;                  // single grids that don't end with "GGGGG"
+    long rows[GRID_MAX_ROWS + 1];   // solved single grids by number of rows
+    long cells[GRID_MAX_ROWS][GRID_COLS][4]; // solved Wordles, aligned on their final row
+    int64_t first_ms, last_ms;      // creation time range (0 if unknown)
+} scan_stats_t;
+
+typedef struct
+{
+    const char *begin, *end; // whole lines
+    scan_stats_t stats;
+} job_t;
+
+static int record_len = CONFIG_TWEET_BUF_LEN;
+static int max_tokens = CONFIG_JSON_MAX_TOKENS;
+static const char *tag = CONFIG_TWITTER_WORDLE_TAG;
+
+static void scan_record(lwjson_t *json, char *buf, scan_stats_t *s)
+{
+    gridscan_t scan;
+    game_t game;
+    grid_t grid;
+    char *text;
+    int64_t created_ms;
+    int row, col;
+
+    if (lwjson_parse(json, buf) != lwjsonOK)
+    {
+        s->json_failed++;
+        return;
+    }
+    if (!tweet_tagged(json, tag))
+    {
+        s->untagged++;
+        return;
+    }
+    text = tweet_text(json);
+    if (text == NULL)
+    {
+        s->no_text++;
+        return;
+    }
+
+    created_ms = tweet_created_at(json);
+    if (created_ms != 0)
+    {
+        if (s->first_ms == 0 || created_ms < s->first_ms)
+            s->first_ms = created_ms;
+        if (created_ms > s->last_ms)
+            s->last_ms = created_ms;
+    }
+
+    game = gridscan(text, &scan);
+    if (game == GAME_NONE)
+    {
+        s->not_grid++;
+        return;
+    }
+    s->games[game]++;
+    s->high_contrast += scan.high_contrast;
+
+    if (scan.board.num_grids != 1)
+        return;
+    grid = scan.grid;
+    if (!grid_solved(grid))
+    {
+        s->unsolved++;
+        return;
+    }
+    s->rows[scan.rows]++;
+    if (game != GAME_WORDLE)
+        return;
+    for (row = 0; row < scan.rows; row++)
+    {
+        for (col = 0; col < GRID_COLS; col++)
+            s->cells[GRID_MAX_ROWS - scan.rows + row][col][grid_cell(grid, row, col)]++;
+    }
+}
+
+static void *scan_range(void *arg)
+{
+    job_t *job = arg;
+    scan_stats_t *s = &job->stats;
+    const char *p = job->begin, *nl;
+    lwjson_token_t *tokens = malloc(max_tokens * sizeof(lwjson_token_t));
+    char *buf = malloc(record_len);
+    lwjson_t json;
+    size_t len;
+
+    if (tokens == NULL || buf == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    lwjson_init(&json, tokens, max_tokens);
+
+    for (; p < job->end; p = nl + 1)
+    {
+        nl = memchr(p, '\n', job->end - p);
+        if (nl == NULL)
+            nl = job->end;
+        len = nl - p;
+        if (len > 0 && p[len - 1] == '\r')
+            len--;
+
+        // (skip keep-alive newlines, like the parser task)
+        if (len == 0 || p[0] != '{')
+            continue;
+        s->records++;
+
+        // the parser terminates strings in place, so each record gets copied
+        if (len > (size_t)record_len - 1)
+        {
+            s->too_long++;
+            continue;
+        }
+        memcpy(buf, p, len);
+        buf[len] = 0;
+        scan_record(&json, buf, s);
+    }
+
+    free(buf);
+    free(tokens);
+
+    return NULL;
+}
+
+static void merge(scan_stats_t *total, const scan_stats_t *s)
+{
+    const long *src = &s->records;
+    long *dst = &total->records;
+    size_t i;
+
+    // every field up to the time range is a counter
+    for (i = 0; i < offsetof(scan_stats_t, first_ms) / sizeof(long); i++)
+        dst[i] += src[i];
+
+    if (s->first_ms != 0 && (total->first_ms == 0 || s->first_ms < total->first_ms))
+        total->first_ms = s->first_ms;
+    if (s->last_ms > total->last_ms)
+        total->last_ms = s->last_ms;
+}
+
+// scan one archive with all threads, returns its size or -1
+static long scan_file(const char *path, int threads, scan_stats_t *total)
+{
+    struct stat st;
+    const char *data, *end;
+    pthread_t *tids;
+    job_t *jobs;
+    size_t size;
+    int fd, t;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        perror(path);
+        return -1;
+    }
+    size = st.st_size;
+    if (size == 0)
+    {
+        close(fd);
+        return 0;
+    }
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        perror(path);
+        return -1;
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+    end = data + size;
+
+    tids = malloc(threads * sizeof(pthread_t));
+    jobs = calloc(threads, sizeof(job_t));
+    if (tids == NULL || jobs == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    // equal ranges, each moved forward to the start of a line
+    for (t = 0; t < threads; t++)
+    {
+        const char *p = data + size * t / threads;
+
+        if (t > 0)
+        {
+            p = p > jobs[t - 1].begin ? p : jobs[t - 1].begin;
+            while (p > data && p < end && p[-1] != '\n')
+                p++;
+        }
+        jobs[t].begin = p;
+        if (t > 0)
+            jobs[t - 1].end = p;
+    }
+    jobs[threads - 1].end = end;
+
+    for (t = 0; t < threads; t++)
+        pthread_create(&tids[t], NULL, scan_range, &jobs[t]);
+    for (t = 0; t < threads; t++)
+    {
+        pthread_join(tids[t], NULL);
+        merge(total, &jobs[t].stats);
+    }
+
+    munmap((void *)data, size);
+    free(jobs);
+    free(tids);
+
+    return size;
+}
+
+static void print_time(const char *label, int64_t ms)
+{
+    time_t t = ms / 1000;
+    char s[32];
+
+    strftime(s, sizeof(s), "%Y-%m-%d %H:%M:%S", gmtime(&t));
+    printf("%s %s UTC\n", label, s);
+}
+
+static void print_stats(const scan_stats_t *s)
+{
+    static const char cell_chars[4] = {[GRID_BLACK] = 'B', [GRID_WHITE] = 'W', [GRID_YELLOW] = 'Y', [GRID_GREEN] = 'G'};
+    long solved = 0, total, n;
+    int g, r, c, k, best;
+
+    printf("%ld records: %ld too long, %ld JSON errors, %ld not tagged \"%s\", %ld without text, %ld without grids\n",
+           s->records, s->too_long, s->json_failed, s->untagged, tag, s->no_text, s->not_grid);
+    for (g = GAME_NONE + 1; g < GAME_NUM; g++)
+        printf("%-10s %ld\n", gridscan_game_name(g), s->games[g]);
+    printf("high contrast: %ld\n", s->high_contrast);
+
+    for (r = 1; r <= GRID_MAX_ROWS; r++)
+        solved += s->rows[r];
+    printf("single grids: %ld solved, %ld unsolved\n", solved, s->unsolved);
+    for (r = 1; r <= GRID_MAX_ROWS; r++)
+        printf("  %d rows: %ld (%.1f%%)\n", r, s->rows[r], solved ? 100.0 * s->rows[r] / solved : 0.0);
+
+    // most frequent color of each cell, rows aligned on the solution
+    printf("solved Wordles, most frequent cells (%% of grids with that row):\n");
+    for (r = 0; r < GRID_MAX_ROWS; r++)
+    {
+        total = 0;
+        for (k = 0; k < 4; k++)
+            total += s->cells[r][0][k];
+        printf("  ");
+        for (c = 0; c < GRID_COLS; c++)
+        {
+            for (k = 1, best = 0; k < 4; k++)
+                best = s->cells[r][c][k] > s->cells[r][c][best] ? k : best;
+            n = s->cells[r][c][best];
+            printf(" %c%3.0f", total ? cell_chars[best] : '-', total ? 100.0 * n / total : 0.0);
+        }
+        printf("   %ld\n", total);
+    }
+
+    if (s->first_ms != 0)
+    {
+        print_time("first tweet:", s->first_ms);
+        print_time("last tweet: ", s->last_ms);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    scan_stats_t total;
+    long bytes = 0, size;
+    int64_t t0, t1;
+    double secs;
+    int i, opt;
+
+    while ((opt = getopt(argc, argv, "j:b:k:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            threads = atoi(optarg);
+            break;
+        case 'b':
+            record_len = atoi(optarg);
+            break;
+        case 'k':
+            max_tokens = atoi(optarg);
+            break;
+        case 't':
+            tag = optarg;
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind >= argc || record_len < 2 || max_tokens < 1)
+    {
+        fprintf(stderr, "usage: %s [-j threads] [-b record_len] [-k tokens] [-t tag] archive.jsonl...\n", argv[0]);
+        return 1;
+    }
+    if (threads < 1)
+        threads = 1;
+
+    gridscan_init();
+    memset(&total, 0, sizeof(total));
+
+    t0 = host_time_us();
+    for (i = optind; i < argc; i++)
+    {
+        size = scan_file(argv[i], threads, &total);
+        if (size < 0)
+            return 1;
+        bytes += size;
+    }
+    t1 = host_time_us();
+
+    print_stats(&total);
+
+    secs = (t1 - t0) / 1e6;
+    printf("%ld bytes in %.3f s with %d threads: %.2f GB/s, %.0f records/s\n", bytes, secs, threads,
+           secs > 0 ? bytes / secs / 1e9 : 0.0, secs > 0 ? total.records / secs : 0.0);
+
+    return 0;
+}
@@ -0,0 +1,359 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    Host build: infers the solution of a puzzle from the grids shared for it.
+    Each row of a grid is the color pattern of some allowed guess against the
+    solution, so a candidate solution survives a grid only if every row's
+    pattern can be produced by at least one guess. The pattern of every
+    (guess, solution) pair is precomputed in parallel, then folded into one
+    bitset of candidate solutions per pattern, so that each grid costs a few
+    bitset intersections.
+
+    usage: wordsolve -a answers.txt [-g guesses.txt] [-j threads] [-v] [grids.txt]
+
+    Word lists have one 5-letter word per line (the guesses default to the
+    answers, and the answers are always allowed as guesses). Grids are read
+    from the file or stdin: every run of 'G' / 'Y' / 'B' / 'W' whose length is
+    a multiple of 5 is a grid, so the log of the device, the "grid" fields of
+    /status and plain lists all work. Grids that would rule out every
+    remaining candidate are counted as inconsistent and skipped.
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "grid.h"
+#include "port.h"
+
+// 3^5 color patterns, base 3 with the first letter as the least significant digit
+#define NUM_PATTERNS 243
+
+// a word is 5 letters of 5 bits each
+typedef uint32_t word_t;
+
+static word_t *words; // answers first, then the other guesses
+static int num_answers, num_words;
+static int bitset_len; // 64-bit words per set of answers
+
+// the pattern table: answers that some guess colors with each pattern
+static uint64_t *answers_with; // [pattern][bitset_len]
+
+static int letter(word_t w, int i)
+{
+    return (w >> (5 * i)) & 31;
+}
+
+static void print_word(word_t w, FILE *f)
+{
+    int i;
+
+    for (i = 0; i < 5; i++)
+        fputc('a' + letter(w, i), f);
+}
+
+// Wordle scoring, repeated letters included
+static uint8_t score(word_t guess, word_t answer)
+{
+    int left[26] = {0};
+    int digits[5] = {0};
+    int i, p = 0;
+
+    for (i = 0; i < 5; i++)
+    {
+        if (letter(guess, i) == letter(answer, i))
+            digits[i] = 2;
+        else
+            left[letter(answer, i)]++;
+    }
+    for (i = 0; i < 5; i++)
+    {
+        if (digits[i] == 0 && left[letter(guess, i)] > 0)
+        {
+            left[letter(guess, i)]--;
+            digits[i] = 1;
+        }
+    }
+    for (i = 4; i >= 0; i--)
+        p = p * 3 + digits[i];
+
+    return p;
+}
+
+// appends the words of a list, skipping duplicates of the answers
+static int load_words(const char *path, int answers)
+{
+    char line[64];
+    FILE *f = fopen(path, "r");
+    int cap = num_words, i, n;
+    word_t w;
+
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        for (i = 0, n = 0, w = 0; line[i] != 0 && n <= 5; i++)
+        {
+            if (isalpha((unsigned char)line[i]))
+                w |= (word_t)(tolower((unsigned char)line[i]) - 'a') << (5 * n++);
+            else if (!isspace((unsigned char)line[i]))
+                n = 6;
+        }
+        if (n != 5)
+            continue;
+        if (!answers)
+        {
+            for (i = 0; i < num_answers && words[i] != w; i++)
+                ;
+            if (i < num_answers)
+                continue;
+        }
+        if (num_words == cap)
+        {
+            cap = cap ? 2 * cap : 4096;
+            words = realloc(words, cap * sizeof(word_t));
+            if (words == NULL)
+                exit(1);
+        }
+        words[num_words++] = w;
+    }
+    fclose(f);
+
+    if (answers)
+        num_answers = num_words;
+
+    return 0;
+}
+
+typedef struct
+{
+    int first, last; // 64-answer blocks
+} job_t;
+
+// each thread owns a range of whole 64-bit words of every answer set,
+// so the threads never write to the same word
+static void *build(void *arg)
+{
+    job_t *job = arg;
+    int a0 = 64 * job->first, a1 = 64 * job->last;
+    int g, a;
+    uint8_t p;
+
+    if (a1 > num_answers)
+        a1 = num_answers;
+
+    for (g = 0; g < num_words; g++)
+    {
+        for (a = a0; a < a1; a++)
+        {
+            p = score(words[g], words[a]);
+            answers_with[p * bitset_len + a / 64] |= 1ULL << (a % 64);
+        }
+    }
+
+    return NULL;
+}
+
+static int count(const uint64_t *set)
+{
+    int i, n = 0;
+
+    for (i = 0; i < bitset_len; i++)
+        n += __builtin_popcountll(set[i]);
+
+    return n;
+}
+
+static void print_candidates(const uint64_t *set, int max)
+{
+    int a, n = 0;
+
+    for (a = 0; a < num_answers && n < max; a++)
+    {
+        if (set[a / 64] & (1ULL << (a % 64)))
+        {
+            fputc(n++ ? ' ' : '\t', stdout);
+            print_word(words[a], stdout);
+        }
+    }
+    if (count(set) > max)
+        fputs(" ...", stdout);
+    fputc('\n', stdout);
+}
+
+// pattern of a grid row, in the digits used by score()
+static int row_pattern(grid_t grid, int row)
+{
+    static const int digit[4] = {[GRID_BLACK] = 0, [GRID_WHITE] = 0, [GRID_YELLOW] = 1, [GRID_GREEN] = 2};
+    int col, p = 0;
+
+    for (col = 4; col >= 0; col--)
+        p = p * 3 + digit[grid_cell(grid, row, col)];
+
+    return p;
+}
+
+int main(int argc, char **argv)
+{
+    const char *answers_path = NULL, *guesses_path = NULL;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN), verbose = 0;
+    uint64_t *cand, *next;
+    pthread_t *tids;
+    job_t *jobs;
+    FILE *in = stdin;
+    char line[4096], run[GRID_COLS * GRID_MAX_ROWS + 1];
+    long grids = 0, inconsistent = 0, converged_at = 0;
+    int i, t, opt, rows, len, n, left;
+    int64_t t0, t1;
+    grid_t grid;
+
+    while ((opt = getopt(argc, argv, "a:g:j:v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            answers_path = optarg;
+            break;
+        case 'g':
+            guesses_path = optarg;
+            break;
+        case 'j':
+            threads = atoi(optarg);
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        default:
+            answers_path = NULL;
+            break;
+        }
+    }
+    if (answers_path == NULL || optind < argc - 1)
+    {
+        fprintf(stderr, "usage: %s -a answers.txt [-g guesses.txt] [-j threads] [-v] [grids.txt]\n", argv[0]);
+        return 1;
+    }
+    if (optind < argc && (in = fopen(argv[optind], "r")) == NULL)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (load_words(answers_path, 1) < 0 || (guesses_path != NULL && load_words(guesses_path, 0) < 0))
+        return 1;
+    if (num_answers == 0)
+    {
+        fprintf(stderr, "no 5-letter words in %s\n", answers_path);
+        return 1;
+    }
+
+    // precompute the pattern table
+    bitset_len = (num_answers + 63) / 64;
+    if (threads < 1)
+        threads = 1;
+    if (threads > bitset_len)
+        threads = bitset_len;
+    answers_with = calloc((size_t)NUM_PATTERNS * bitset_len, sizeof(uint64_t));
+    cand = malloc(bitset_len * sizeof(uint64_t));
+    next = malloc(bitset_len * sizeof(uint64_t));
+    tids = malloc(threads * sizeof(pthread_t));
+    jobs = malloc(threads * sizeof(job_t));
+    if (answers_with == NULL || cand == NULL || next == NULL || tids == NULL || jobs == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    t0 = host_time_us();
+    for (t = 0; t < threads; t++)
+    {
+        jobs[t].first = bitset_len * t / threads;
+        jobs[t].last = bitset_len * (t + 1) / threads;
+        pthread_create(&tids[t], NULL, build, &jobs[t]);
+    }
+    for (t = 0; t < threads; t++)
+        pthread_join(tids[t], NULL);
+    t1 = host_time_us();
+    fprintf(stderr, "%d answers, %d guesses: pattern table built in %.1f ms with %d threads\n", num_answers, num_words,
+            (t1 - t0) / 1000.0, threads);
+
+    // every answer is a candidate to begin with
+    memset(cand, 0xff, bitset_len * sizeof(uint64_t));
+    if (num_answers % 64)
+        cand[bitset_len - 1] = (1ULL << (num_answers % 64)) - 1;
+    left = num_answers;
+
+    t0 = host_time_us();
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        for (i = 0, len = 0;; i++)
+        {
+            if (line[i] == 'G' || line[i] == 'Y' || line[i] == 'B' || line[i] == 'W')
+            {
+                if (len < (int)sizeof(run) - 1)
+                    run[len] = line[i];
+                len++;
+                continue;
+            }
+
+            // end of a run: is it a grid?
+            rows = len / GRID_COLS;
+            if (len > 0 && len % GRID_COLS == 0 && rows <= GRID_MAX_ROWS)
+            {
+                grid = grid_encode(run, rows);
+                grids++;
+
+                memcpy(next, cand, bitset_len * sizeof(uint64_t));
+                for (t = 0; t < rows; t++)
+                {
+                    const uint64_t *set = answers_with + row_pattern(grid, t) * bitset_len;
+
+                    for (n = 0; n < bitset_len; n++)
+                        next[n] &= set[n];
+                }
+
+                n = count(next);
+                if (n == 0)
+                    inconsistent++;
+                else if (n < left)
+                {
+                    memcpy(cand, next, bitset_len * sizeof(uint64_t));
+                    left = n;
+                    if (verbose)
+                    {
+                        printf("after %ld grids: %d candidates", grids, left);
+                        print_candidates(cand, 10);
+                    }
+                    if (left == 1 && converged_at == 0)
+                        converged_at = grids;
+                }
+            }
+            len = 0;
+            if (line[i] == 0)
+                break;
+        }
+    }
+    t1 = host_time_us();
+
+    printf("%ld grids (%ld inconsistent) in %.1f ms: %d candidates", grids, inconsistent, (t1 - t0) / 1000.0, left);
+    print_candidates(cand, 20);
+    if (converged_at > 0)
+        printf("converged after %ld grids\n", converged_at);
+    else
+        printf("not converged\n");
+
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "bytering.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/task.h"
+
+// Each side owns its index and only reads the other one. A side about to
+// sleep raises its *_waiting flag and then re-checks the ring, while the
+// other side publishes its index and then clears the flag: with sequentially
+// consistent accesses on both sides, one of the two always sees the other,
+// so no wakeup is lost and no semaphore is given while nobody waits.
+
+bytering_t *bytering_create(size_t size, bytering_wake_t wake, size_t wake_bytes, TickType_t linger)
+{
+    bytering_t *r = calloc(1, sizeof(bytering_t));
+
+    if (r == NULL)
+        return NULL;
+
+    r->buf = malloc(size);
+    r->data_sem = xSemaphoreCreateBinary();
+    r->space_sem = xSemaphoreCreateBinary();
+    if (r->buf == NULL || r->data_sem == NULL || r->space_sem == NULL)
+    {
+        bytering_delete(r);
+        return NULL;
+    }
+
+    r->size = size;
+    r->wake = wake;
+    r->wake_bytes = wake_bytes > 0 ? wake_bytes : 1;
+    r->linger = linger;
+
+    return r;
+}
+
+void bytering_delete(bytering_t *r)
+{
+    if (r->data_sem != NULL)
+        vSemaphoreDelete(r->data_sem);
+    if (r->space_sem != NULL)
+        vSemaphoreDelete(r->space_sem);
+    free(r->buf);
+    free(r);
+}
+
+// bytes up to the last wakeup that the consumer has not released yet
+static size_t ready_bytes(bytering_t *r, size_t tail)
+{
+    size_t n = atomic_load(&r->ready) - tail;
+
+    // (ready lags behind tail once partial data has been consumed)
+    return n <= r->size ? n : 0;
+}
+
+size_t bytering_reserve(bytering_t *r, uint8_t **span)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    size_t idx = head % r->size;
+    size_t n = r->size - (head - tail);
+
+    *span = r->buf + idx;
+
+    return n < r->size - idx ? n : r->size - idx;
+}
+
+void bytering_commit(bytering_t *r, size_t len)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t ready = 0, tail;
+    int wake = 0;
+    size_t i;
+
+    if (len == 0)
+        return;
+
+    atomic_store_explicit(&r->head, head + len, memory_order_release);
+
+    if (r->wake == BYTERING_WAKE_NEWLINE)
+    {
+        // the committed span is contiguous (see bytering_reserve)
+        const uint8_t *p = r->buf + head % r->size;
+
+        for (i = len; i > 0; i--)
+        {
+            if (p[i - 1] == '\n')
+            {
+                ready = head + i;
+                wake = 1;
+                break;
+            }
+        }
+    }
+    else
+    {
+        r->pending += len;
+        if (r->pending >= r->wake_bytes)
+        {
+            ready = head + len;
+            wake = 1;
+        }
+    }
+
+    // a full ring must be drained, whatever the wake condition (in newline
+    // mode only if it holds no whole line, i.e. a line longer than the ring)
+    tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (!wake && head + len - tail == r->size && (r->wake != BYTERING_WAKE_NEWLINE || ready_bytes(r, tail) == 0))
+    {
+        ready = head + len;
+        wake = 1;
+    }
+
+    if (!wake)
+    {
+        // bytes mode: a consumer asleep on an empty ring is woken by the first
+        // bytes, only so that it starts its linger timeout (see bytering_receive)
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load(&r->consumer_waiting) == BYTERING_WAITING_EMPTY &&
+            atomic_exchange(&r->consumer_waiting, 0))
+            xSemaphoreGive(r->data_sem);
+        return;
+    }
+
+    r->pending = 0;
+    atomic_store(&r->ready, ready);
+    if (atomic_exchange(&r->consumer_waiting, 0))
+    {
+        atomic_fetch_add_explicit(&r->wakeups, 1, memory_order_relaxed);
+        xSemaphoreGive(r->data_sem);
+    }
+}
+
+size_t bytering_reserve_wait(bytering_t *r, uint8_t **span, TickType_t ticks)
+{
+    size_t n;
+
+    while ((n = bytering_reserve(r, span)) == 0)
+    {
+        atomic_store(&r->producer_waiting, 1);
+        // (bytering_reserve loads tail with acquire only: without the fence
+        // that load could move before the store, and miss the consumer's wakeup)
+        atomic_thread_fence(memory_order_seq_cst);
+        if (bytering_reserve(r, span) > 0)
+        {
+            // the consumer made room meanwhile (and may have given space_sem)
+            if (!atomic_exchange(&r->producer_waiting, 0))
+                xSemaphoreTake(r->space_sem, 0);
+            continue;
+        }
+        if (xSemaphoreTake(r->space_sem, ticks) != pdTRUE)
+        {
+            if (!atomic_exchange(&r->producer_waiting, 0))
+                xSemaphoreTake(r->space_sem, 0);
+            return bytering_reserve(r, span);
+        }
+    }
+
+    return n;
+}
+
+size_t bytering_send(bytering_t *r, const void *data, size_t len, TickType_t ticks)
+{
+    const uint8_t *src = data;
+    uint8_t *span;
+    size_t sent = 0, n;
+
+    while (sent < len)
+    {
+        n = bytering_reserve_wait(r, &span, ticks);
+        if (n == 0)
+            break;
+        if (n > len - sent)
+            n = len - sent;
+        memcpy(span, src + sent, n);
+        bytering_commit(r, n);
+        sent += n;
+    }
+
+    return sent;
+}
+
+size_t bytering_peek(bytering_t *r, const uint8_t **span)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    size_t idx = tail % r->size;
+    size_t n = head - tail;
+
+    *span = r->buf + idx;
+
+    return n < r->size - idx ? n : r->size - idx;
+}
+
+void bytering_release(bytering_t *r, size_t len)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    atomic_store(&r->tail, tail + len);
+    if (atomic_load(&r->producer_waiting) && atomic_exchange(&r->producer_waiting, 0))
+        xSemaphoreGive(r->space_sem);
+}
+
+// length of the whole lines in the first len bytes after tail, 0 if none
+static size_t last_line_end(bytering_t *r, size_t tail, size_t len)
+{
+    size_t i;
+
+    for (i = len; i > 0; i--)
+    {
+        if (r->buf[(tail + i - 1) % r->size] == '\n')
+            return i;
+    }
+
+    return 0;
+}
+
+size_t bytering_receive(bytering_t *r, void *data, size_t len, TickType_t ticks)
+{
+    uint8_t *dst = data;
+    const uint8_t *span;
+    TickType_t start = xTaskGetTickCount(), elapsed, wait;
+    size_t tail, n = 0, avail, chunk, line;
+    int lingered = 0, empty;
+
+    while (1)
+    {
+        tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        avail = bytering_bytes_available(r);
+
+        n = ready_bytes(r, tail);
+        if (n > 0)
+        {
+            if (r->wake == BYTERING_WAKE_BYTES)
+                n = avail;
+            break;
+        }
+
+        elapsed = xTaskGetTickCount() - start;
+        if (lingered || (ticks != portMAX_DELAY && elapsed >= ticks))
+        {
+            n = avail;
+            break;
+        }
+
+        // sleep until the wake condition holds, or linger with partial data
+        wait = ticks == portMAX_DELAY ? portMAX_DELAY : ticks - elapsed;
+        if (avail > 0 && r->linger < wait)
+            wait = r->linger;
+
+        // (without data, a bytes mode consumer must hear about the first bytes:
+        // linger runs from then on, while they may never reach wake_bytes)
+        empty = r->wake == BYTERING_WAKE_BYTES && avail == 0;
+        atomic_store(&r->consumer_waiting, empty ? BYTERING_WAITING_EMPTY : 1);
+        if (ready_bytes(r, tail) > 0 || (empty && atomic_load(&r->head) != tail))
+        {
+            if (!atomic_exchange(&r->consumer_waiting, 0))
+                xSemaphoreTake(r->data_sem, 0);
+            continue;
+        }
+        if (xSemaphoreTake(r->data_sem, wait) != pdTRUE)
+        {
+            if (!atomic_exchange(&r->consumer_waiting, 0))
+                xSemaphoreTake(r->data_sem, 0);
+            lingered = avail > 0;
+        }
+    }
+
+    if (n > len)
+        n = len;
+
+    // whole lines only, even after a forced wakeup (full ring, linger), as
+    // long as there is one: a partial line goes out only when it's all there is
+    if (r->wake == BYTERING_WAKE_NEWLINE && (line = last_line_end(r, tail, n)) > 0)
+        n = line;
+
+    // copy out, in two pieces at the wrap point
+    for (avail = n; avail > 0; avail -= chunk)
+    {
+        chunk = bytering_peek(r, &span);
+        if (chunk > avail)
+            chunk = avail;
+        memcpy(dst, span, chunk);
+        dst += chunk;
+        bytering_release(r, chunk);
+    }
+
+    return n;
+}
+
+size_t bytering_bytes_available(bytering_t *r)
+{
+    return atomic_load_explicit(&r->head, memory_order_acquire) -
+           atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
@@ -0,0 +1,83 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __BYTERING_H__
+#define __BYTERING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// single-producer / single-consumer byte ring: the indices are lock-free,
+// semaphores are only touched when the other side is actually asleep
+
+// when the producer wakes the consumer
+typedef enum
+{
+    BYTERING_WAKE_BYTES,   // at least wake_bytes committed since the last wakeup
+    BYTERING_WAKE_NEWLINE, // a '\n' was committed (the consumer gets whole lines)
+} bytering_wake_t;
+
+// consumer asleep on an empty ring (bytes mode: any commit wakes it up)
+#define BYTERING_WAITING_EMPTY 2
+
+typedef struct
+{
+    uint8_t *buf;
+    size_t size;
+    bytering_wake_t wake;
+    size_t wake_bytes;
+    TickType_t linger; // consumer returns partial data after waiting this long
+
+    // free-running byte counts (indices are taken modulo size)
+    atomic_size_t head;  // committed by the producer
+    atomic_size_t ready; // up to here the wake condition holds
+    atomic_size_t tail;  // released by the consumer
+
+    size_t pending; // producer only: committed since the last wakeup
+
+    atomic_int consumer_waiting; // 1, or BYTERING_WAITING_EMPTY
+    atomic_int producer_waiting;
+    SemaphoreHandle_t data_sem;
+    SemaphoreHandle_t space_sem;
+
+    atomic_uint wakeups; // consumer wakeups signalled by the producer
+} bytering_t;
+
+// returns NULL if out of memory
+bytering_t *bytering_create(size_t size, bytering_wake_t wake, size_t wake_bytes, TickType_t linger);
+void bytering_delete(bytering_t *r);
+
+// producer: contiguous free span (shorter than the free space at the wrap point)
+size_t bytering_reserve(bytering_t *r, uint8_t **span);
+void bytering_commit(bytering_t *r, size_t len);
+
+// producer: like bytering_reserve(), waiting up to ticks while the ring is full
+size_t bytering_reserve_wait(bytering_t *r, uint8_t **span, TickType_t ticks);
+
+// producer: copy data in, waiting up to ticks for space, returns bytes sent
+size_t bytering_send(bytering_t *r, const void *data, size_t len, TickType_t ticks);
+
+// consumer: contiguous readable span
+size_t bytering_peek(bytering_t *r, const uint8_t **span);
+void bytering_release(bytering_t *r, size_t len);
+
+// consumer: wait up to ticks for a wakeup, then copy out up to len bytes
+// (in BYTERING_WAKE_NEWLINE mode, whole lines only, unless linger expired,
+// the ring filled up or a line is longer than len: the consumer must keep
+// an unterminated tail until the rest of the line arrives)
+size_t bytering_receive(bytering_t *r, void *data, size_t len, TickType_t ticks);
+
+size_t bytering_bytes_available(bytering_t *r);
+
+#endif /* __BYTERING_H__ **/
@@ -0,0 +1,255 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "capture.h"
+#include "metrics.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "mbedtls/base64.h"
+
+#define CAPTURE_STACK_SIZE 3072
+
+// largest chunk (a single TLS read)
+#define CAPTURE_CHUNK_MAX (sizeof(capture_chunk_t) + CONFIG_STREAM_READ_BUF_SIZE)
+
+#if defined(CONFIG_STREAM_CAPTURE_CONSOLE) || defined(CONFIG_STREAM_CAPTURE_FLASH)
+
+static RingbufHandle_t capture_buf;
+
+// stream task only
+static int64_t last_us;
+static uint16_t seq;
+
+#ifdef CONFIG_STREAM_CAPTURE_FLASH
+
+static const esp_partition_t *partition;
+static size_t offset; // next byte to write
+static size_t erased; // erased up to here
+
+// append to the partition, erasing a sector ahead so that the end is
+// always followed by an erased header
+static int flash_append(const void *data, size_t len)
+{
+    size_t ahead;
+
+    if (offset + len > partition->size)
+        return 0;
+
+    ahead = offset + len + sizeof(capture_chunk_t);
+    while (erased < ahead && erased < partition->size)
+    {
+        if (esp_partition_erase_range(partition, erased, SPI_FLASH_SEC_SIZE) != ESP_OK)
+            return 0;
+        erased += SPI_FLASH_SEC_SIZE;
+    }
+    if (esp_partition_write(partition, offset, data, len) != ESP_OK)
+        return 0;
+    offset += len;
+
+    return 1;
+}
+
+static void write_chunk(const uint8_t *item, size_t len)
+{
+    static int full;
+
+    if (flash_append(item, len))
+        return;
+
+    metrics_inc(METRIC_CAPTURE_DROPPED);
+    if (!full)
+    {
+        ESP_LOGW(TAG, "capture partition full after %u bytes", (unsigned)offset);
+        full = 1;
+    }
+}
+
+#else
+
+static void write_chunk(const uint8_t *item, size_t len)
+{
+    // the console is a text channel (and may translate line endings), hence base64
+    static unsigned char line[(CAPTURE_CHUNK_MAX + 2) / 3 * 4 + 1];
+    size_t olen;
+
+    mbedtls_base64_encode(line, sizeof(line), &olen, item, len);
+    printf("CAPTURE:%.*s\n", (int)olen, line);
+}
+
+#endif /* CONFIG_STREAM_CAPTURE_FLASH */
+
+static void capture_task(void *pvParameters)
+{
+    size_t len;
+    uint8_t *item;
+
+    while (1)
+    {
+        item = xRingbufferReceive(capture_buf, &len, portMAX_DELAY);
+        if (item == NULL)
+            continue;
+
+        write_chunk(item, len);
+        vRingbufferReturnItem(capture_buf, item);
+    }
+}
+
+void capture_init(void)
+{
+#ifdef CONFIG_STREAM_CAPTURE_FLASH
+    const capture_header_t header = {
+        .magic = CAPTURE_MAGIC,
+        .version = CAPTURE_VERSION,
+        .chunk_size = sizeof(capture_chunk_t),
+    };
+
+    // a new capture replaces the previous one
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CAPTURE_PARTITION);
+    if (partition == NULL || !flash_append(&header, sizeof(header)))
+    {
+        ESP_LOGE(TAG, "no usable \"%s\" partition, stream capture disabled", CAPTURE_PARTITION);
+        return;
+    }
+    ESP_LOGI(TAG, "capturing the stream to partition \"%s\" (%u bytes)", CAPTURE_PARTITION,
+             (unsigned)partition->size);
+#endif
+
+    capture_buf = xRingbufferCreate(CONFIG_STREAM_CAPTURE_BUF_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (capture_buf == NULL)
+    {
+        ESP_LOGE(TAG, "cannot allocate capture buffer, stream capture disabled");
+        return;
+    }
+
+    // lowest priority above idle, like the tweet log
+    xTaskCreate(&capture_task, "capture", CAPTURE_STACK_SIZE, NULL, 1, NULL);
+}
+
+void capture_chunk(const uint8_t *data, size_t len)
+{
+    capture_chunk_t *chunk;
+    int64_t now = esp_timer_get_time();
+    int64_t delta = last_us ? now - last_us : 0;
+
+    last_us = now;
+
+    // never wait: a full buffer means the console or flash can't keep up
+    // (the chunk number still advances, so the gap shows in the capture)
+    if (capture_buf == NULL ||
+        xRingbufferSendAcquire(capture_buf, (void **)&chunk, sizeof(capture_chunk_t) + len, 0) != pdTRUE)
+    {
+        seq++;
+        metrics_inc(METRIC_CAPTURE_DROPPED);
+        return;
+    }
+
+    chunk->delta_us = delta > UINT32_MAX ? UINT32_MAX : delta;
+    chunk->len = len;
+    chunk->seq = seq++;
+    if (len > 0)
+        memcpy(chunk + 1, data, len);
+    xRingbufferSendComplete(capture_buf, chunk);
+}
+
+#endif /* CONFIG_STREAM_CAPTURE_CONSOLE || CONFIG_STREAM_CAPTURE_FLASH */
+
+#ifdef CONFIG_STREAM_REPLAY
+
+// wakes the replaying task up when the next chunk is due
+static void replay_timer_cb(void *arg)
+{
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+void capture_replay(bytering_t *ring)
+{
+    const esp_timer_create_args_t args = {
+        .callback = &replay_timer_cb,
+        .arg = xTaskGetCurrentTaskHandle(),
+        .name = "stream_replay",
+    };
+    esp_timer_handle_t timer;
+    const esp_partition_t *part;
+    capture_header_t header;
+    capture_chunk_t chunk;
+    size_t pos, done, n;
+    uint8_t *span;
+    int64_t due, wait;
+    unsigned int chunks = 0, connections = 0, bytes = 0;
+
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CAPTURE_PARTITION);
+    if (part == NULL || esp_partition_read(part, 0, &header, sizeof(header)) != ESP_OK ||
+        memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 || header.version != CAPTURE_VERSION ||
+        header.chunk_size != sizeof(capture_chunk_t))
+    {
+        ESP_LOGE(TAG, "no capture in partition \"%s\"", CAPTURE_PARTITION);
+        return;
+    }
+    if (esp_timer_create(&args, &timer) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "cannot create the replay timer");
+        return;
+    }
+    ESP_LOGI(TAG, "replaying the stream captured in partition \"%s\"", CAPTURE_PARTITION);
+
+    // chunks are due at their original times from the start of the replay, to
+    // the microsecond (a one-shot esp_timer rather than ticks, and no spinning);
+    // a late chunk doesn't delay the next ones
+    due = esp_timer_get_time();
+    for (pos = sizeof(header); pos + sizeof(chunk) <= part->size; pos += sizeof(chunk) + chunk.len)
+    {
+        if (esp_partition_read(part, pos, &chunk, sizeof(chunk)) != ESP_OK || chunk.len == 0xffff ||
+            pos + sizeof(chunk) + chunk.len > part->size)
+            break;
+
+        due += chunk.delta_us;
+        wait = due - esp_timer_get_time();
+        if (wait > 0 && esp_timer_start_once(timer, wait) == ESP_OK)
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (chunk.len == 0)
+        {
+            connections++;
+            continue;
+        }
+
+        // reserved and committed like the stream task does; the pieces
+        // depend on how far the parser has drained the ring by now, so a
+        // chunk may be split differently than on the device (the bytes and
+        // their times are the same)
+        for (done = 0; done < chunk.len; done += n)
+        {
+            n = bytering_reserve_wait(ring, &span, portMAX_DELAY);
+            if (n > chunk.len - done)
+                n = chunk.len - done;
+            esp_partition_read(part, pos + sizeof(chunk) + done, span, n);
+            bytering_commit(ring, n);
+        }
+        chunks++;
+        bytes += chunk.len;
+        metrics_add(METRIC_BYTES_READ, chunk.len);
+        trace_event_id(TRACE_TLS_READ, TRACE_INSTANT, chunk.len);
+    }
+
+    esp_timer_delete(timer);
+    ESP_LOGI(TAG, "replay done: %u chunks, %u connections, %u bytes", chunks, connections, bytes);
+}
+
+#endif /* CONFIG_STREAM_REPLAY */
@@ -0,0 +1,70 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bytering.h"
+
+// Raw stream capture. Every chunk returned by mbedtls_ssl_read() is recorded
+// with its read boundaries and timing, so that the stream can be replayed
+// exactly, on the device or on the host (host/streamreplay.c). The stream
+// task only enqueues (never blocks, chunks that don't fit are dropped and
+// counted), and a low priority task writes them to the console or to the
+// "capture" flash partition.
+
+// one chunk, followed by len bytes, little endian
+typedef struct __attribute__((packed))
+{
+    uint32_t delta_us; // since the previous chunk (saturated)
+    uint16_t len;      // 0: a new connection starts
+    uint16_t seq;      // chunk number, gaps are dropped chunks
+} capture_chunk_t;
+
+// the flash partition starts with this header, chunks follow until an
+// erased header (len 0xffff); on the console each chunk is a "CAPTURE:"
+// line, base64 encoded
+#define CAPTURE_MAGIC "WCAP"
+#define CAPTURE_VERSION 1
+#define CAPTURE_PARTITION "capture"
+
+typedef struct __attribute__((packed))
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t chunk_size; // sizeof(capture_chunk_t)
+} capture_header_t;
+
+#if defined(CONFIG_STREAM_CAPTURE_CONSOLE) || defined(CONFIG_STREAM_CAPTURE_FLASH)
+
+void capture_init(void);
+
+// from the stream task only: a chunk just read (len 0 marks a new connection)
+void capture_chunk(const uint8_t *data, size_t len);
+
+#else
+
+#define capture_init()
+#define capture_chunk(data, len)
+
+#endif
+
+#ifdef CONFIG_STREAM_REPLAY
+
+// feed the captured chunks from the flash partition to the stream ring,
+// with their original boundaries and timing (returns at the end)
+void capture_replay(bytering_t *ring);
+
+#endif /* CONFIG_STREAM_REPLAY */
+
+#endif /* __CAPTURE_H__ **/
@@ -0,0 +1,89 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "dedup.h"
+
+#include <stddef.h>
+
+#include "sdkconfig.h"
+
+#define DEDUP_SET_SIZE CONFIG_DEDUP_SET_SIZE
+#define DEDUP_MASK (DEDUP_SET_SIZE - 1)
+#define DEDUP_WINDOW_US ((int64_t)CONFIG_DEDUP_WINDOW_S * 1000000)
+
+// linear probing stops after this many slots
+#define DEDUP_MAX_PROBE 8
+
+_Static_assert((DEDUP_SET_SIZE & DEDUP_MASK) == 0, "CONFIG_DEDUP_SET_SIZE must be a power of two");
+
+// a slot is free when its grid is 0 (a grid has at least one row) or it has expired
+typedef struct
+{
+    grid_t grid;
+    int64_t seen_us; // first time shown in the current window
+} dedup_entry_t;
+
+static dedup_entry_t set[DEDUP_SET_SIZE];
+
+static int expired(const dedup_entry_t *e, int64_t now_us)
+{
+    return e->grid == 0 || now_us - e->seen_us >= DEDUP_WINDOW_US;
+}
+
+// the live entry holding grid, or NULL with *victim set to the slot to reuse
+static dedup_entry_t *lookup(grid_t grid, int64_t now_us, dedup_entry_t **victim)
+{
+    uint32_t i = grid_hash(grid) & DEDUP_MASK;
+    dedup_entry_t *e;
+    int probe;
+
+    // scan the whole probe run, since slots before a live copy may have expired
+    *victim = NULL;
+    for (probe = 0; probe < DEDUP_MAX_PROBE; probe++, i = (i + 1) & DEDUP_MASK)
+    {
+        e = &set[i];
+
+        if (expired(e, now_us))
+        {
+            if (*victim == NULL || !expired(*victim, now_us))
+                *victim = e;
+            continue;
+        }
+
+        if (e->grid == grid)
+            return e;
+
+        // otherwise evict the oldest live entry
+        if (*victim == NULL || (!expired(*victim, now_us) && e->seen_us < (*victim)->seen_us))
+            *victim = e;
+    }
+
+    return NULL;
+}
+
+int dedup_seen(grid_t grid, int64_t now_us)
+{
+    dedup_entry_t *victim;
+
+    return lookup(grid, now_us, &victim) != NULL;
+}
+
+int dedup_check(grid_t grid, int64_t now_us)
+{
+    dedup_entry_t *victim;
+
+    if (lookup(grid, now_us, &victim) != NULL)
+        return 1;
+
+    victim->grid = grid;
+    victim->seen_us = now_us;
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __DEDUP_H__
+#define __DEDUP_H__
+
+#include <stdint.h>
+
+#include "grid.h"
+
+// Recently shown grids, in a fixed-size open-addressing hash set whose
+// entries expire after the window. Not thread safe (used by the renderer only).
+
+// returns 1 if the grid was already seen less than window_us ago, otherwise
+// remembers it (evicting the oldest entry of its probe run if needed) and returns 0
+int dedup_check(grid_t grid, int64_t now_us);
+
+// same check, without remembering the grid
+int dedup_seen(grid_t grid, int64_t now_us);
+
+#endif /* __DEDUP_H__ **/
@@ -0,0 +1,95 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "display.h"
+#include "ledmatrix.h"
+#include "stats.h"
+#include "heatmap.h"
+
+#include "driver/gpio.h"
+#include "esp_timer.h"
+
+// button cycling the display modes (BOOT on the ESP32-C3 board, active low)
+#define DISPLAY_BUTTON_GPIO CONFIG_DISPLAY_BUTTON_GPIO
+#define DISPLAY_BUTTON_DEBOUNCE_US 200000
+
+static const char *mode_names[] = {
+    [DISPLAY_GRIDS] = "grids",
+    [DISPLAY_STATS] = "stats",
+    [DISPLAY_HEATMAP] = "heatmap",
+};
+
+static volatile display_mode_t mode = DISPLAY_GRIDS;
+
+#if DISPLAY_BUTTON_GPIO >= 0
+static void IRAM_ATTR button_isr(void *arg)
+{
+    static int64_t last_press;
+    int64_t now = esp_timer_get_time();
+
+    if (now - last_press > DISPLAY_BUTTON_DEBOUNCE_US)
+        mode = (mode + 1) % DISPLAY_MODE_NUM;
+    last_press = now;
+}
+#endif
+
+void display_init(void)
+{
+#if DISPLAY_BUTTON_GPIO >= 0
+    const gpio_config_t button = {
+        .pin_bit_mask = 1ULL << DISPLAY_BUTTON_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+
+    ESP_ERROR_CHECK(gpio_config(&button));
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(DISPLAY_BUTTON_GPIO, button_isr, NULL));
+#endif
+}
+
+display_mode_t display_get_mode(void)
+{
+    return mode;
+}
+
+void display_set_mode(display_mode_t m)
+{
+    if (m < DISPLAY_MODE_NUM)
+        mode = m;
+}
+
+const char *display_mode_name(display_mode_t m)
+{
+    return m < DISPLAY_MODE_NUM ? mode_names[m] : "?";
+}
+
+void display_draw(display_mode_t m)
+{
+    uint8_t pixels[LEDMATRIX_TILE_PIXELS][3];
+
+    switch (m)
+    {
+    case DISPLAY_STATS:
+        stats_draw(pixels);
+        break;
+
+    case DISPLAY_HEATMAP:
+        heatmap_draw(pixels);
+        break;
+
+    default:
+        return;
+    }
+
+    ledmatrix_draw(pixels);
+}
@@ -0,0 +1,34 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __DISPLAY_H__
+#define __DISPLAY_H__
+
+// what the LED matrix shows, cycled with the button
+typedef enum
+{
+    DISPLAY_GRIDS, // incoming Wordles
+    DISPLAY_STATS, // guess distribution of the current puzzle
+    DISPLAY_HEATMAP, // green / yellow share of each cell over the last minutes
+    DISPLAY_MODE_NUM,
+} display_mode_t;
+
+// other modes are redrawn this often
+#define DISPLAY_REFRESH_MS 1000
+
+void display_init(void);
+display_mode_t display_get_mode(void);
+void display_set_mode(display_mode_t mode);
+const char *display_mode_name(display_mode_t mode);
+
+// draw a mode other than DISPLAY_GRIDS
+void display_draw(display_mode_t mode);
+
+#endif /* __DISPLAY_H__ **/
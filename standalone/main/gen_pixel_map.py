@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Generate pixel_map.h, the strip index of every LED matrix pixel.
+
+The panel is a chain of identical tiles (a single tile by default), each
+wired row by row from its top left corner, optionally in serpentine order
+(every other row runs right to left). Tiles are chained row by row from the
+top left of the panel, optionally in serpentine order as well. Pixels are
+numbered row by row from the top left of the whole panel, so ledmatrix.c
+never needs to know how the LEDs are wired.
+
+usage: gen_pixel_map.py --width W --height H [--tile-width TW] [--tile-height TH]
+                        [--serpentine] [--tile-serpentine] -o pixel_map.h
+
+Run by main/CMakeLists.txt with the geometry from the project configuration.
+"""
+
+import argparse
+import sys
+
+
+def pixel_map(width, height, tile_width, tile_height, serpentine, tile_serpentine):
+    tiles_x = width // tile_width
+    tile_pixels = tile_width * tile_height
+    index = []
+    for y in range(height):
+        for x in range(width):
+            ty, tx = y // tile_height, x // tile_width
+            row, col = y % tile_height, x % tile_width
+            if tile_serpentine and ty % 2:
+                tx = tiles_x - 1 - tx
+            if serpentine and row % 2:
+                col = tile_width - 1 - col
+            index.append((ty * tiles_x + tx) * tile_pixels + row * tile_width + col)
+    return index
+
+
+def main(argv):
+    p = argparse.ArgumentParser(description="Generate the LED matrix pixel map.")
+    p.add_argument("--width", type=int, required=True)
+    p.add_argument("--height", type=int, required=True)
+    p.add_argument("--tile-width", type=int, default=0, help="default: the panel width")
+    p.add_argument("--tile-height", type=int, default=0, help="default: the panel height")
+    p.add_argument("--serpentine", action="store_true", help="rows alternate direction within a tile")
+    p.add_argument("--tile-serpentine", action="store_true", help="tile rows alternate direction")
+    p.add_argument("-o", "--output", required=True)
+    args = p.parse_args(argv[1:])
+
+    tile_width = args.tile_width or args.width
+    tile_height = args.tile_height or args.height
+    if args.width <= 0 or args.height <= 0 or args.width % tile_width or args.height % tile_height:
+        sys.stderr.write("gen_pixel_map.py: the panel must be a whole number of tiles\n")
+        return 1
+
+    index = pixel_map(args.width, args.height, tile_width, tile_height,
+                      args.serpentine, args.tile_serpentine)
+
+    wiring = "%dx%d tiles of %dx%d%s%s" % (args.width // tile_width, args.height // tile_height,
+                                           tile_width, tile_height,
+                                           ", serpentine rows" if args.serpentine else "",
+                                           ", serpentine tile chain" if args.tile_serpentine else "")
+    lines = [
+        "// generated by gen_pixel_map.py, do not edit",
+        "// %dx%d pixels: %s" % (args.width, args.height, wiring),
+        "",
+        "#define PIXEL_MAP_WIDTH %d" % args.width,
+        "#define PIXEL_MAP_HEIGHT %d" % args.height,
+        "",
+        "static const uint16_t pixel_map[%d] = {" % len(index),
+    ]
+    for y in range(args.height):
+        row = index[y * args.width:(y + 1) * args.width]
+        lines.append("    " + ", ".join("%d" % i for i in row) + ",")
+    lines.append("};")
+
+    with open(args.output, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
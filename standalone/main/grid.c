@@ -0,0 +1,50 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "grid.h"
+
+static const char cell_chars[4] = {'B', 'W', 'Y', 'G'};
+
+grid_t grid_encode(const char *s, int num_lines)
+{
+    grid_t g = 0;
+    int i, cell;
+
+    for (i = 0; i < GRID_COLS * num_lines; i++)
+    {
+        switch (s[i])
+        {
+        case 'G':
+            cell = GRID_GREEN;
+            break;
+        case 'Y':
+            cell = GRID_YELLOW;
+            break;
+        case 'W':
+            cell = GRID_WHITE;
+            break;
+        default:
+            cell = GRID_BLACK;
+            break;
+        }
+        g |= (grid_t)cell << (2 * i);
+    }
+
+    return grid_set_rows(g, num_lines);
+}
+
+void grid_decode(grid_t g, char *s)
+{
+    int i;
+
+    for (i = 0; i < GRID_COLS * grid_rows(g); i++)
+        s[i] = cell_chars[(g >> (2 * i)) & 3];
+    s[i] = 0;
+}
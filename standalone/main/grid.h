@@ -0,0 +1,103 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __GRID_H__
+#define __GRID_H__
+
+#include <stdint.h>
+
+// A Wordle grid packed in one integer: 2 bits per cell, row by row from
+// bit 0 (cell (row, col) at bits 2 * (5 * row + col)), and the number of
+// rows in the top 4 bits. Grids compare and hash as plain integers.
+typedef uint64_t grid_t;
+
+#define GRID_COLS 5
+#define GRID_MAX_ROWS 6
+#define GRID_ROWS_SHIFT 60
+
+// cell colors
+#define GRID_BLACK 0
+#define GRID_WHITE 1 // (light mode "absent", shown like black)
+#define GRID_YELLOW 2
+#define GRID_GREEN 3
+
+// a solved last row
+#define GRID_ROW_GREEN 0x3ff
+
+static inline int grid_rows(grid_t g)
+{
+    return (int)(g >> GRID_ROWS_SHIFT);
+}
+
+static inline int grid_cell(grid_t g, int row, int col)
+{
+    return (int)(g >> (2 * (GRID_COLS * row + col))) & 3;
+}
+
+// the 10 bits of one row
+static inline int grid_row(grid_t g, int row)
+{
+    return (int)(g >> (2 * GRID_COLS * row)) & 0x3ff;
+}
+
+static inline grid_t grid_set_cell(grid_t g, int row, int col, int cell)
+{
+    int shift = 2 * (GRID_COLS * row + col);
+
+    return (g & ~((grid_t)3 << shift)) | ((grid_t)cell << shift);
+}
+
+static inline grid_t grid_set_rows(grid_t g, int rows)
+{
+    return (g & ~((grid_t)0xf << GRID_ROWS_SHIFT)) | ((grid_t)rows << GRID_ROWS_SHIFT);
+}
+
+static inline int grid_solved(grid_t g)
+{
+    return grid_rows(g) > 0 && grid_row(g, grid_rows(g) - 1) == GRID_ROW_GREEN;
+}
+
+// well mixed 32-bit hash (MurmurHash3 finalizer)
+static inline uint32_t grid_hash(grid_t g)
+{
+    g ^= g >> 33;
+    g *= 0xff51afd7ed558ccdULL;
+    g ^= g >> 33;
+    g *= 0xc4ceb9fe1a85ec53ULL;
+    g ^= g >> 33;
+
+    return (uint32_t)g;
+}
+
+// The grids of a multi-grid result (Dordle, Quordle, Octordle) go past the
+// rows a grid_t holds: a board keeps one 10-bit word per row instead (cells
+// as in grid_row()), grids left to right, then top to bottom.
+#define GRID_BOARD_MAX_GRIDS 8
+#define GRID_BOARD_MAX_ROWS 13
+
+typedef struct
+{
+    uint8_t num_grids;
+    uint8_t cols;                       // grids side by side
+    uint8_t rows[GRID_BOARD_MAX_GRIDS]; // of each grid
+    uint16_t cells[GRID_BOARD_MAX_GRIDS][GRID_BOARD_MAX_ROWS];
+} grid_board_t;
+
+static inline int grid_board_cell(const grid_board_t *b, int grid, int row, int col)
+{
+    return (b->cells[grid][row] >> (2 * col)) & 3;
+}
+
+// from / to one character per cell ('G' / 'Y' / 'B' / 'W'), row by row;
+// decode writes 5 * rows characters and a NUL
+grid_t grid_encode(const char *s, int num_lines);
+void grid_decode(grid_t g, char *s);
+
+#endif /* __GRID_H__ **/
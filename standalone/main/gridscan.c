@@ -0,0 +1,429 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "gridscan.h"
+
+#include <string.h>
+
+// The text is split into tokens by a byte-level Aho-Corasick automaton built
+// from the glyph table below, in raw UTF-8 and as JSON \u escapes. Tokens
+// then drive a small line / block state machine, and the shape of the grids
+// found picks the game. Adding glyphs or games only grows the tables: every
+// byte still costs one table lookup.
+
+// tokens: cells carry their color and palette, the rest are separators
+#define TOK_CELL 0x04
+#define TOK_HIGH_CONTRAST 0x08
+#define TOK_SPACE 0x10
+#define TOK_NEWLINE 0x11
+#define TOK_IGNORE 0x12
+
+typedef struct
+{
+    uint32_t code_point;
+    uint8_t token;
+} glyph_t;
+
+static const glyph_t glyphs[] = {
+    {0x1F7E9, TOK_CELL | GRID_GREEN},                     // 🟩
+    {0x1F7E8, TOK_CELL | GRID_YELLOW},                    // 🟨
+    {0x2B1B, TOK_CELL | GRID_BLACK},                      // ⬛
+    {0x2B1C, TOK_CELL | GRID_WHITE},                      // ⬜
+    {0x1F7E7, TOK_CELL | TOK_HIGH_CONTRAST | GRID_GREEN}, // 🟧 (high contrast: right spot)
+    {0x1F7E6, TOK_CELL | TOK_HIGH_CONTRAST | GRID_YELLOW}, // 🟦 (high contrast: wrong spot)
+    {0xFE0F, TOK_IGNORE},                                 // emoji presentation selector
+    {' ', TOK_SPACE},
+};
+
+typedef struct
+{
+    game_t game;
+    const char *name;
+    const char *keyword; // NULL: any text
+    int cols, blocks;    // grids side by side, blocks of rows one below the other
+    int max_rows;
+} game_shape_t;
+
+// first match wins
+static const game_shape_t games[] = {
+    {GAME_WORDLE, "wordle", "Wordle", 1, 1, GRID_MAX_ROWS},
+    {GAME_WORDLIKE, "wordlike", NULL, 1, 1, GRID_MAX_ROWS},
+    {GAME_DORDLE, "dordle", NULL, 2, 1, 7},
+    {GAME_QUORDLE, "quordle", NULL, 2, 2, 9},
+    {GAME_OCTORDLE, "octordle", NULL, 2, 4, 13},
+};
+
+#define MAX_COLS 2
+#define MAX_BLOCKS 4
+#define MAX_BLOCK_ROWS GRID_BOARD_MAX_ROWS
+
+_Static_assert(MAX_COLS * MAX_BLOCKS <= GRID_BOARD_MAX_GRIDS, "a board must hold every grid");
+
+// automaton size: raw UTF-8, lowercase and uppercase \u escapes of every glyph
+#define MAX_STATES 128
+#define MAX_CLASSES 48
+#define MAX_PATTERN 12
+
+static uint8_t byte_class[256];
+static int num_classes;
+static uint8_t delta[MAX_STATES][MAX_CLASSES];
+static uint8_t out_token[MAX_STATES];
+static uint8_t out_len[MAX_STATES];
+static int num_states;
+
+static int utf8_encode(uint32_t cp, char *s)
+{
+    if (cp < 0x80)
+    {
+        s[0] = cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        s[0] = 0xC0 | (cp >> 6);
+        s[1] = 0x80 | (cp & 0x3F);
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        s[0] = 0xE0 | (cp >> 12);
+        s[1] = 0x80 | ((cp >> 6) & 0x3F);
+        s[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    }
+    s[0] = 0xF0 | (cp >> 18);
+    s[1] = 0x80 | ((cp >> 12) & 0x3F);
+    s[2] = 0x80 | ((cp >> 6) & 0x3F);
+    s[3] = 0x80 | (cp & 0x3F);
+    return 4;
+}
+
+// "\uXXXX", or a surrogate pair, in the given hex digits
+static int json_escape(uint32_t cp, char *s, const char *hex)
+{
+    uint32_t units[2];
+    int n = 0, i, j;
+
+    if (cp >= 0x10000)
+    {
+        units[n++] = 0xD800 + ((cp - 0x10000) >> 10);
+        units[n++] = 0xDC00 + ((cp - 0x10000) & 0x3FF);
+    }
+    else
+        units[n++] = cp;
+
+    for (i = 0; i < n; i++)
+    {
+        *s++ = '\\';
+        *s++ = 'u';
+        for (j = 12; j >= 0; j -= 4)
+            *s++ = hex[(units[i] >> j) & 0xF];
+    }
+
+    return 6 * n;
+}
+
+static void add_pattern(const char *p, int len, uint8_t token)
+{
+    int i, s = 0, c;
+
+    for (i = 0; i < len; i++)
+    {
+        c = (uint8_t)p[i];
+        if (byte_class[c] == 0)
+            byte_class[c] = num_classes++;
+        c = byte_class[c];
+        if (delta[s][c] == 0)
+            delta[s][c] = num_states++;
+        s = delta[s][c];
+    }
+    out_token[s] = token;
+    out_len[s] = len;
+}
+
+void gridscan_init(void)
+{
+    uint8_t queue[MAX_STATES], fail[MAX_STATES] = {0};
+    char p[MAX_PATTERN];
+    int head = 0, tail = 0, s, c, t, len;
+    size_t i;
+
+    memset(byte_class, 0, sizeof(byte_class));
+    memset(delta, 0, sizeof(delta));
+    memset(out_token, 0, sizeof(out_token));
+    num_classes = 1; // class 0: bytes in no pattern
+    num_states = 1;  // state 0: root
+
+    // trie of all spellings (no spelling is a prefix of another)
+    add_pattern("\\n", 2, TOK_NEWLINE);
+    for (i = 0; i < sizeof(glyphs) / sizeof(glyphs[0]); i++)
+    {
+        len = utf8_encode(glyphs[i].code_point, p);
+        add_pattern(p, len, glyphs[i].token);
+        if (glyphs[i].code_point >= 0x80)
+        {
+            len = json_escape(glyphs[i].code_point, p, "0123456789abcdef");
+            add_pattern(p, len, glyphs[i].token);
+            len = json_escape(glyphs[i].code_point, p, "0123456789ABCDEF");
+            add_pattern(p, len, glyphs[i].token);
+        }
+    }
+
+    // breadth first, turn the trie into a complete automaton:
+    // missing transitions follow the failure links
+    for (c = 0; c < num_classes; c++)
+        if (delta[0][c] != 0)
+            queue[tail++] = delta[0][c];
+    while (head < tail)
+    {
+        s = queue[head++];
+        if (out_token[s] == 0 && out_token[fail[s]] != 0)
+        {
+            out_token[s] = out_token[fail[s]];
+            out_len[s] = out_len[fail[s]];
+        }
+        for (c = 0; c < num_classes; c++)
+        {
+            t = delta[s][c];
+            if (t != 0)
+            {
+                fail[t] = delta[fail[s]][c];
+                queue[tail++] = t;
+            }
+            else
+                delta[s][c] = delta[fail[s]][c];
+        }
+    }
+}
+
+// per-line state
+enum
+{
+    LINE_START,
+    LINE_GROUP,   // inside a group of cells
+    LINE_SPACE,   // after a complete group and a space
+    LINE_CLOSED,  // the row is over, the rest of the line is ignored
+    LINE_NOT_ROW, // text, or a group of the wrong width
+};
+
+typedef struct
+{
+    int line, cells, groups, blank, high_contrast;
+    int row[MAX_COLS];
+
+    int cols;   // of the grids found so far
+    int blocks; // complete blocks
+    int block_rows[MAX_BLOCKS];
+    int in_block, done, high_contrast_rows;
+    uint16_t grid_cells[MAX_COLS * MAX_BLOCKS][MAX_BLOCK_ROWS]; // one word per row (see grid_board_t)
+} scan_t;
+
+static void new_line(scan_t *sc)
+{
+    sc->line = LINE_START;
+    sc->cells = sc->groups = 0;
+    sc->blank = 1;
+    sc->high_contrast = 0;
+    sc->row[0] = sc->row[1] = 0;
+}
+
+static void close_block(scan_t *sc)
+{
+    if (sc->in_block)
+    {
+        sc->in_block = 0;
+        sc->blocks++;
+    }
+}
+
+static void end_line(scan_t *sc)
+{
+    int b, r, col;
+
+    if (sc->line == LINE_GROUP)
+        sc->line = sc->cells == GRID_COLS ? (sc->groups++, LINE_CLOSED) : LINE_NOT_ROW;
+
+    if (sc->line == LINE_NOT_ROW || sc->groups == 0)
+    {
+        // blank lines separate blocks, text after the grids ends them
+        close_block(sc);
+        if (!sc->blank && sc->blocks > 0)
+            sc->done = 1;
+        new_line(sc);
+        return;
+    }
+
+    // a row: continue the current block, or start the next one
+    if (!sc->in_block)
+    {
+        if (sc->blocks == MAX_BLOCKS || (sc->blocks > 0 && sc->groups != sc->cols))
+        {
+            sc->done = 1;
+            return;
+        }
+        sc->cols = sc->groups;
+        sc->in_block = 1;
+        sc->block_rows[sc->blocks] = 0;
+    }
+    else if (sc->groups != sc->cols)
+    {
+        close_block(sc);
+        sc->done = 1;
+        return;
+    }
+
+    b = sc->blocks;
+    r = sc->block_rows[b]++;
+    if (r == MAX_BLOCK_ROWS)
+    {
+        sc->done = 1;
+        return;
+    }
+    for (col = 0; col < sc->cols; col++)
+        sc->grid_cells[b * sc->cols + col][r] = sc->row[col];
+    sc->high_contrast_rows |= sc->high_contrast;
+
+    new_line(sc);
+}
+
+static void feed(scan_t *sc, int tok)
+{
+    if (tok == TOK_NEWLINE)
+    {
+        end_line(sc);
+        return;
+    }
+    if (tok == TOK_IGNORE || sc->line >= LINE_CLOSED)
+        return;
+
+    if (tok & TOK_CELL)
+    {
+        sc->blank = 0;
+        if (sc->line == LINE_GROUP && sc->cells == GRID_COLS)
+        {
+            sc->line = LINE_NOT_ROW; // too wide
+            return;
+        }
+        if (sc->line == LINE_SPACE && sc->groups == MAX_COLS)
+        {
+            sc->line = LINE_CLOSED;
+            return;
+        }
+        if (sc->line != LINE_GROUP)
+        {
+            sc->line = LINE_GROUP;
+            sc->cells = 0;
+        }
+        sc->row[sc->groups] |= (tok & 3) << (2 * sc->cells++);
+        sc->high_contrast |= (tok & TOK_HIGH_CONTRAST) != 0;
+        return;
+    }
+
+    if (tok == TOK_SPACE)
+    {
+        if (sc->line == LINE_GROUP)
+            sc->line = sc->cells == GRID_COLS ? (sc->groups++, LINE_SPACE) : LINE_NOT_ROW;
+        else if (sc->line == LINE_SPACE)
+            sc->line = LINE_CLOSED;
+        return;
+    }
+
+    // anything else
+    sc->blank = 0;
+    if (sc->line == LINE_START)
+        sc->line = LINE_NOT_ROW;
+    else if (sc->line == LINE_GROUP)
+        sc->line = sc->cells == GRID_COLS ? (sc->groups++, LINE_CLOSED) : LINE_NOT_ROW;
+    else
+        sc->line = LINE_CLOSED;
+}
+
+game_t gridscan(const char *s, gridscan_t *result)
+{
+    const uint8_t *p = (const uint8_t *)s;
+    scan_t sc;
+    size_t i, last_end = 0;
+    int state = 0, tok, b, g, r, rows;
+
+    memset(&sc, 0, sizeof(sc));
+    new_line(&sc);
+    memset(result, 0, sizeof(*result));
+
+    for (i = 0; p[i] != 0 && !sc.done; i++)
+    {
+        state = delta[state][byte_class[p[i]]];
+        tok = out_token[state];
+        if (tok == 0)
+            continue;
+
+        // bytes skipped since the previous token are text
+        if (i + 1 - out_len[state] > last_end)
+            feed(&sc, 0);
+        feed(&sc, tok);
+        last_end = i + 1;
+        state = 0;
+    }
+    if (!sc.done)
+    {
+        if (i > last_end)
+            feed(&sc, 0);
+        end_line(&sc);
+    }
+    close_block(&sc);
+
+    if (sc.blocks == 0)
+        return GAME_NONE;
+
+    rows = 0;
+    for (b = 0; b < sc.blocks; b++)
+        if (sc.block_rows[b] > rows)
+            rows = sc.block_rows[b];
+
+    for (i = 0; i < sizeof(games) / sizeof(games[0]); i++)
+    {
+        if (games[i].cols != sc.cols || games[i].blocks != sc.blocks || rows > games[i].max_rows)
+            continue;
+        if (games[i].keyword != NULL && strstr(s, games[i].keyword) == NULL)
+            continue;
+
+        result->game = games[i].game;
+        result->rows = rows;
+        result->high_contrast = sc.high_contrast_rows;
+        result->board.num_grids = sc.cols * sc.blocks;
+        result->board.cols = sc.cols;
+        for (g = 0; g < result->board.num_grids; g++)
+        {
+            result->board.rows[g] = sc.block_rows[g / sc.cols];
+            memcpy(result->board.cells[g], sc.grid_cells[g], sc.block_rows[g / sc.cols] * sizeof(uint16_t));
+        }
+
+        // single-grid games fit a grid_t (max_rows <= GRID_MAX_ROWS)
+        if (result->board.num_grids == 1)
+        {
+            for (r = 0; r < rows; r++)
+                result->grid |= (grid_t)sc.grid_cells[0][r] << (2 * GRID_COLS * r);
+            result->grid = grid_set_rows(result->grid, rows);
+        }
+        return result->game;
+    }
+
+    return GAME_NONE;
+}
+
+const char *gridscan_game_name(game_t game)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(games) / sizeof(games[0]); i++)
+        if (games[i].game == game)
+            return games[i].name;
+
+    return "none";
+}
@@ -0,0 +1,47 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __GRIDSCAN_H__
+#define __GRIDSCAN_H__
+
+#include "grid.h"
+
+// games told apart by the shape of their grids (and a keyword, for games
+// with the same shape)
+typedef enum
+{
+    GAME_NONE,
+    GAME_WORDLE,
+    GAME_WORDLIKE, // other games with one 5-wide grid of up to 6 rows
+    GAME_DORDLE,
+    GAME_QUORDLE,
+    GAME_OCTORDLE,
+    GAME_NUM,
+} game_t;
+
+typedef struct
+{
+    game_t game;
+    int rows;           // rows of the tallest grid
+    int high_contrast;  // orange / blue cells, stored as green / yellow
+    grid_t grid;        // single-grid games: the grid (board.num_grids == 1)
+    grid_board_t board; // every grid, with all of its rows
+} gridscan_t;
+
+// build the recognizer tables (once, before the first gridscan)
+void gridscan_init(void);
+
+// finds the grids in a tweet's text (JSON string contents, "\n" escapes
+// separating lines) in a single pass, returns GAME_NONE if there are none
+game_t gridscan(const char *s, gridscan_t *result);
+
+const char *gridscan_game_name(game_t game);
+
+#endif /* __GRIDSCAN_H__ **/
@@ -0,0 +1,131 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "heatmap.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+// the window is split into slices, the oldest slice is dropped as a whole
+#define HEATMAP_SLICES 10
+#define HEATMAP_SLICE_US ((int64_t)CONFIG_HEATMAP_WINDOW_MIN * 60000000 / HEATMAP_SLICES)
+
+// matrix rows, counted from the bottom (the final row of every grid)
+#define HEATMAP_ROWS 5
+
+typedef struct
+{
+    uint32_t grids[HEATMAP_ROWS]; // grids reaching up to each row
+    uint32_t green[HEATMAP_ROWS][GRID_COLS];
+    uint32_t yellow[HEATMAP_ROWS][GRID_COLS];
+} heatmap_counts_t;
+
+// per-slice counts, and their sum over the window
+static heatmap_counts_t slices[HEATMAP_SLICES];
+static heatmap_counts_t total;
+static int64_t slice_start; // start time of slices[current]
+static int current;
+static portMUX_TYPE heatmap_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// drop the slices that fell out of the window (heatmap_mux held)
+static void advance(int64_t now)
+{
+    uint32_t *t = (uint32_t *)&total, *s;
+    int i, n;
+
+    for (n = 0; now - slice_start >= HEATMAP_SLICE_US && n < HEATMAP_SLICES; n++)
+    {
+        current = (current + 1) % HEATMAP_SLICES;
+        slice_start += HEATMAP_SLICE_US;
+
+        // (the struct is all uint32_t counters)
+        s = (uint32_t *)&slices[current];
+        for (i = 0; i < (int)(sizeof(heatmap_counts_t) / sizeof(uint32_t)); i++)
+            t[i] -= s[i];
+        memset(&slices[current], 0, sizeof(heatmap_counts_t));
+    }
+
+    // idle for longer than the window: everything is gone already
+    if (now - slice_start >= HEATMAP_SLICE_US)
+        slice_start = now;
+}
+
+void heatmap_add(grid_t grid)
+{
+    int rows = grid_rows(grid);
+    int row, col, r, cell;
+    heatmap_counts_t *s;
+
+    portENTER_CRITICAL(&heatmap_mux);
+    advance(esp_timer_get_time());
+    s = &slices[current];
+
+    // bottom row r shows grid row rows - 1 - r
+    for (r = 0; r < HEATMAP_ROWS && r < rows; r++)
+    {
+        row = rows - 1 - r;
+        s->grids[r]++;
+        total.grids[r]++;
+        for (col = 0; col < GRID_COLS; col++)
+        {
+            cell = grid_cell(grid, row, col);
+            if (cell == GRID_GREEN)
+            {
+                s->green[r][col]++;
+                total.green[r][col]++;
+            }
+            else if (cell == GRID_YELLOW)
+            {
+                s->yellow[r][col]++;
+                total.yellow[r][col]++;
+            }
+        }
+    }
+
+    portEXIT_CRITICAL(&heatmap_mux);
+}
+
+void heatmap_draw(uint8_t pixels[LEDMATRIX_TILE_PIXELS][3])
+{
+    heatmap_counts_t t;
+    uint8_t *p;
+    int r, col, g, y;
+
+    portENTER_CRITICAL(&heatmap_mux);
+    advance(esp_timer_get_time());
+    t = total;
+    portEXIT_CRITICAL(&heatmap_mux);
+
+    for (r = 0; r < HEATMAP_ROWS; r++)
+    {
+        for (col = 0; col < GRID_COLS; col++)
+        {
+            p = pixels[GRID_COLS * (HEATMAP_ROWS - 1 - r) + col];
+            if (t.grids[r] == 0)
+            {
+                memset(p, 0, 3);
+                continue;
+            }
+
+            // green share in the green channel, yellow share as red + green
+            g = 32 * t.green[r][col] / t.grids[r];
+            y = 32 * t.yellow[r][col] / t.grids[r];
+            p[0] = y;
+            p[1] = g + y;
+            p[2] = 0;
+
+            // a dim white floor, so that rows with data are visible
+            if (p[0] < 2 && p[1] < 2)
+                p[0] = p[1] = p[2] = 2;
+        }
+    }
+}
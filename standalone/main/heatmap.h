@@ -0,0 +1,28 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __HEATMAP_H__
+#define __HEATMAP_H__
+
+#include <stdint.h>
+
+#include "grid.h"
+#include "ledmatrix.h"
+
+// Per-cell share of green and yellow over the grids of the last
+// HEATMAP_WINDOW_MIN minutes, with grids aligned on their final row
+// (as drawn by ledmatrix_update). Kept as per-slice counters plus running
+// totals, so adding a grid and drawing are both constant time.
+
+void heatmap_add(grid_t grid);
+
+void heatmap_draw(uint8_t pixels[LEDMATRIX_TILE_PIXELS][3]);
+
+#endif /* __HEATMAP_H__ **/
@@ -0,0 +1,164 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "history.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+#define HISTORY_LEN CONFIG_GRID_HISTORY_LEN
+
+// the grids are saved at most this often, and only if new ones were shown
+#define HISTORY_FLUSH_PERIOD_US ((uint64_t)CONFIG_GRID_HISTORY_FLUSH_PERIOD * 1000000)
+
+#define HISTORY_NVS_NAMESPACE "history"
+#define HISTORY_NVS_KEY "grids"
+
+// ring buffer, guarded by a spinlock (critical sections are short copies only)
+static history_entry_t ring[HISTORY_LEN];
+static int head = 0;  // next slot to write
+static int count = 0; // valid entries
+static int dirty;
+static portMUX_TYPE ring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t flush_task;
+
+// what is saved: packed grids, newest first
+typedef struct
+{
+    uint8_t count;
+    uint8_t games[HISTORY_LEN];
+    grid_t grids[HISTORY_LEN];
+} history_blob_t;
+
+void history_add(grid_t grid, game_t game)
+{
+    history_entry_t e;
+
+    e.timestamp_us = esp_timer_get_time();
+    e.grid = grid;
+    e.game = game;
+
+    portENTER_CRITICAL(&ring_mux);
+    ring[head] = e;
+    head = (head + 1) % HISTORY_LEN;
+    if (count < HISTORY_LEN)
+        count++;
+    dirty = 1;
+    portEXIT_CRITICAL(&ring_mux);
+}
+
+// one blob per flush period at most, however many grids were shown
+// (NVS spreads the writes over its pages)
+static void history_flush(void)
+{
+    history_blob_t blob;
+    nvs_handle_t nvs;
+    int i;
+
+    memset(&blob, 0, sizeof(blob));
+
+    portENTER_CRITICAL(&ring_mux);
+    if (!dirty)
+    {
+        portEXIT_CRITICAL(&ring_mux);
+        return;
+    }
+    blob.count = count;
+    for (i = 0; i < count; i++)
+    {
+        blob.grids[i] = ring[(head - 1 - i + HISTORY_LEN) % HISTORY_LEN].grid;
+        blob.games[i] = ring[(head - 1 - i + HISTORY_LEN) % HISTORY_LEN].game;
+    }
+    dirty = 0;
+    portEXIT_CRITICAL(&ring_mux);
+
+    if (nvs_open(HISTORY_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+        return;
+    nvs_set_blob(nvs, HISTORY_NVS_KEY, &blob, sizeof(blob));
+    nvs_commit(nvs);
+    nvs_close(nvs);
+
+    ESP_LOGD(TAG, "grid history saved (%d grids)", blob.count);
+}
+
+// the NVS write can wait on the flash for a while, so it isn't done on the
+// esp_timer task: the timer only wakes this one up
+static void history_flush_task(void *pvParameters)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        history_flush();
+    }
+}
+
+static void history_flush_cb(void *arg)
+{
+    xTaskNotifyGive(flush_task);
+}
+
+void history_init(void)
+{
+    esp_timer_handle_t timer;
+    history_blob_t blob;
+    size_t len = sizeof(blob);
+    nvs_handle_t nvs;
+    int i;
+
+    // (a blob saved with a different history length is ignored)
+    if (nvs_open(HISTORY_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK)
+    {
+        if (nvs_get_blob(nvs, HISTORY_NVS_KEY, &blob, &len) == ESP_OK && len == sizeof(blob) &&
+            blob.count <= HISTORY_LEN)
+        {
+            // oldest first, so that the newest ends up at the head
+            for (i = blob.count - 1; i >= 0; i--)
+            {
+                ring[head].timestamp_us = 0;
+                ring[head].grid = blob.grids[i];
+                ring[head].game = blob.games[i] < GAME_NUM ? blob.games[i] : GAME_NONE;
+                head = (head + 1) % HISTORY_LEN;
+            }
+            count = blob.count;
+        }
+        nvs_close(nvs);
+    }
+    ESP_LOGI(TAG, "grid history: %d grids restored", count);
+
+    // lowest priority above idle, like the tweet log
+    xTaskCreate(&history_flush_task, "history_flush", HISTORY_FLUSH_STACK_SIZE, NULL, 1, &flush_task);
+
+    const esp_timer_create_args_t args = {
+        .callback = &history_flush_cb,
+        .name = "history_flush",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, HISTORY_FLUSH_PERIOD_US));
+}
+
+int history_get(history_entry_t *entries, int max)
+{
+    int i, n;
+
+    portENTER_CRITICAL(&ring_mux);
+    n = count < max ? count : max;
+    for (i = 0; i < n; i++)
+        entries[i] = ring[(head - 1 - i + HISTORY_LEN) % HISTORY_LEN];
+    portEXIT_CRITICAL(&ring_mux);
+
+    return n;
+}
@@ -0,0 +1,39 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+#include <stdint.h>
+
+#include "grid.h"
+#include "gridscan.h"
+
+// the task saving them (see GRID_HISTORY_FLUSH_PERIOD)
+#define HISTORY_FLUSH_STACK_SIZE 3072
+
+// recently displayed Wordles, saved to NVS so they survive a reboot
+typedef struct
+{
+    int64_t timestamp_us; // esp_timer time when displayed (0: before this boot)
+    grid_t grid;
+    game_t game;
+} history_entry_t;
+
+// load the grids saved before the last reboot (NVS must be initialized)
+void history_init(void);
+
+// a single grid just displayed (multi-grid results aren't kept)
+void history_add(grid_t grid, game_t game);
+
+// copy up to max entries, newest first, returns the number copied
+int history_get(history_entry_t *entries, int max);
+
+#endif /* __HISTORY_H__ **/
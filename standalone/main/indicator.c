@@ -0,0 +1,74 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "indicator.h"
+#include "ledmatrix.h"
+
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const struct
+{
+    const char *name;
+    uint8_t r, g, b;
+} states[] = {
+    [INDICATOR_CONNECTING] = {"connecting", 0, 0, 32},
+    [INDICATOR_HANDSHAKE] = {"handshake", 16, 0, 32},
+    [INDICATOR_STREAMING] = {"streaming", 0, 0, 0},
+    [INDICATOR_STALLED] = {"stalled", 32, 12, 0},
+    [INDICATOR_ERROR] = {"error", 32, 0, 0},
+};
+
+static volatile indicator_state_t state = INDICATOR_CONNECTING;
+static esp_timer_handle_t blink_timer;
+static int blink_phase;
+
+// esp_timer task: the overlay is only requested here, the LED matrix task draws it
+static void blink_timer_cb(void *arg)
+{
+    indicator_state_t s = state;
+
+    blink_phase = !blink_phase;
+    if (s == INDICATOR_STREAMING || !blink_phase)
+        ledmatrix_set_overlay(0, 0, 0, 0);
+    else
+        ledmatrix_set_overlay(1, states[s].r, states[s].g, states[s].b);
+}
+
+void indicator_init(void)
+{
+    const esp_timer_create_args_t args = {
+        .callback = &blink_timer_cb,
+        .name = "indicator",
+    };
+
+    ESP_ERROR_CHECK(esp_timer_create(&args, &blink_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(blink_timer, CONFIG_BLINK_PERIOD * 1000));
+}
+
+void indicator_set(indicator_state_t s)
+{
+    if (s == state)
+        return;
+
+    ESP_LOGI(TAG, "status: %s", states[s].name);
+    state = s;
+
+    // start a new blink cycle right away
+    blink_phase = 0;
+    if (blink_timer != NULL)
+        blink_timer_cb(NULL);
+}
+
+indicator_state_t indicator_get(void)
+{
+    return state;
+}
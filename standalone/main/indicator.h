@@ -0,0 +1,28 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __INDICATOR_H__
+#define __INDICATOR_H__
+
+// connection status, shown on the central LED
+typedef enum
+{
+    INDICATOR_CONNECTING, // associating with the Wi-Fi AP (blinking blue)
+    INDICATOR_HANDSHAKE,  // connecting to the Twitter API (blinking purple)
+    INDICATOR_STREAMING,  // receiving tweets (no overlay)
+    INDICATOR_STALLED,    // stream dropped, waiting to reconnect (blinking amber)
+    INDICATOR_ERROR,      // setup failed, retrying (blinking red)
+} indicator_state_t;
+
+void indicator_init(void);
+void indicator_set(indicator_state_t state);
+indicator_state_t indicator_get(void);
+
+#endif /* __INDICATOR_H__ **/
@@ -12,60 +12,413 @@
 
 #include "ledmatrix.h"
 #include "main.h"
+#include "trace.h"
+
+#include <string.h>
+#include <stdatomic.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+
+// pixel_map[i]: strip index of pixel i (generated by gen_pixel_map.py)
+#include "pixel_map.h"
+
+#if PIXEL_MAP_WIDTH != LEDMATRIX_WIDTH || PIXEL_MAP_HEIGHT != LEDMATRIX_HEIGHT
+#error "pixel_map.h does not match the configured LED matrix geometry"
+#endif
+
+// viewport animation: one pixel per tick, pausing on every grid
+#define SCROLL_TICK_US (CONFIG_LEDMATRIX_SCROLL_MS * 1000)
+#define SCROLL_HOLD_TICKS (CONFIG_LEDMATRIX_SCROLL_HOLD_MS / CONFIG_LEDMATRIX_SCROLL_MS)
+
+// viewport stops: the top of every grid, then one panel height further down
+// at a time until its bottom (at most rows / height + 1 per grid)
+#define MAX_STOPS (LEDMATRIX_MAX_GRIDS * (GRID_BOARD_MAX_ROWS / LEDMATRIX_HEIGHT + 1))
+
+// the animation task: low, each step waits for the strip refresh (RMT)
+#define LEDMATRIX_TASK_PRIORITY 2
+
+// what the animation task is woken up for (notification bits)
+#define LEDMATRIX_NOTIFY_TICK 1
+#define LEDMATRIX_NOTIFY_OVERLAY 2
 
 // LED matrix configuration
 static led_strip_t *pStrip;
 
-void ledmatrix_init(void)
+// what is shown: the most recent single grids (newest last, 0 for empty
+// slots), or the last multi-grid result (if board.num_grids > 0)
+static grid_t recent[LEDMATRIX_SLOTS];
+static grid_board_t board;
+
+// virtual canvas and the part of it in use
+static uint8_t canvas[LEDMATRIX_CANVAS_ROWS][LEDMATRIX_CANVAS_COLS][3];
+static int canvas_w, canvas_h;
+
+static struct
 {
-    pStrip = led_strip_init(CONFIG_BLINK_LED_RMT_CHANNEL, BLINK_GPIO, 25);
-    pStrip->clear(pStrip, 50);
+    int x, y;
+} stops[MAX_STOPS];
+static int num_stops, next_stop, hold;
+static int view_x, view_y; // top left corner of the viewport on the canvas
+
+// viewport pixels, the overlay drawn on top of them, and what the strip shows
+static uint8_t frame[LEDMATRIX_NUM_PIXELS][3];
+static int overlay_on;
+static uint8_t overlay[3];
+static uint8_t shown[LEDMATRIX_NUM_PIXELS][3];
+
+// requested overlay (enable << 24 | r << 16 | g << 8 | b), applied by the
+// animation task so that callers never wait for the strip
+static atomic_uint overlay_req;
+
+// serializes access to the canvas and the strip (the animation task draws
+// the viewport steps and the overlay; the esp_timer task only wakes it up)
+static SemaphoreHandle_t strip_lock;
+static esp_timer_handle_t scroll_timer;
+static TaskHandle_t anim_task;
+
+// write pixel i to the strip if it changed, returns whether it did
+static int push_pixel(int i)
+{
+    uint8_t *p = (overlay_on && i == LEDMATRIX_CENTER) ? overlay : frame[i];
+
+    if (memcmp(shown[i], p, 3) == 0)
+        return 0;
+
+    memcpy(shown[i], p, 3);
+    pStrip->set_pixel(pStrip, pixel_map[i], p[0], p[1], p[2]);
+
+    return 1;
 }
 
-void ledmatrix_update(char *buf, int num_lines)
+// copy the viewport out of the canvas and push the changed pixels (strip_lock held)
+static void refresh_frame(void)
 {
-    int i, j;
+    int i, x, y, dirty = 0;
 
-    ESP_LOGI(TAG, "showing %d-lines Wordle: %s", num_lines, buf);
+    for (i = 0; i < LEDMATRIX_NUM_PIXELS; i++)
+    {
+        x = view_x + i % LEDMATRIX_WIDTH;
+        y = view_y + i / LEDMATRIX_WIDTH;
+        if (x < canvas_w && y < canvas_h)
+            memcpy(frame[i], canvas[y][x], 3);
+        else
+            memset(frame[i], 0, 3);
+        dirty += push_pixel(i);
+    }
+    if (dirty == 0)
+        return;
 
-    for (i = 0; i < 5 * (5 - num_lines); i++)
-        pStrip->set_pixel(pStrip, i, 0, 0, 0);
+    trace_event(TRACE_REFRESH, TRACE_BEGIN);
+    pStrip->refresh(pStrip, 100);
+    trace_event(TRACE_REFRESH, TRACE_END);
+}
 
-    for (j = 0; i < 25; i++, j++)
+// animation tick: glide towards the next stop (columns first), then pause there (strip_lock held)
+static void scroll_tick(void)
+{
+    if (num_stops > 1)
     {
-        switch (buf[j])
+        if (hold > 0)
+            hold--;
+        else
         {
-        case 'G':
-            pStrip->set_pixel(pStrip, i, 0, 32, 0);
-            break;
-
-        case 'Y':
-            pStrip->set_pixel(pStrip, i, 32, 32, 0);
-            break;
-
-        case 'B':
-        case 'W':
-        default:
-            pStrip->set_pixel(pStrip, i, 2, 2, 2);
-            break;
+            if (view_x != stops[next_stop].x)
+                view_x += view_x < stops[next_stop].x ? 1 : -1;
+            else if (view_y != stops[next_stop].y)
+                view_y += view_y < stops[next_stop].y ? 1 : -1;
+
+            if (view_x == stops[next_stop].x && view_y == stops[next_stop].y)
+            {
+                hold = SCROLL_HOLD_TICKS;
+                next_stop = (next_stop + 1) % num_stops;
+            }
+            refresh_frame();
         }
     }
+}
 
-    pStrip->refresh(pStrip, 100);
+// draw the requested overlay on the central LED (strip_lock held)
+static void apply_overlay(void)
+{
+    unsigned int req = atomic_load(&overlay_req);
+    int enable = req >> 24;
+    uint8_t r = req >> 16, g = req >> 8, b = req;
+
+    if (enable != overlay_on || overlay[0] != r || overlay[1] != g || overlay[2] != b)
+    {
+        overlay_on = enable;
+        overlay[0] = r;
+        overlay[1] = g;
+        overlay[2] = b;
+
+        if (push_pixel(LEDMATRIX_CENTER))
+            pStrip->refresh(pStrip, 100);
+    }
 }
 
-void blink_red_forever(void)
+static void ledmatrix_task(void *pvParameters)
 {
+    uint32_t bits;
+
     while (1)
     {
-        pStrip->set_pixel(pStrip, 12, 32, 0, 0); // central LED
-        pStrip->refresh(pStrip, 100);
-        vTaskDelay(CONFIG_BLINK_PERIOD / portTICK_PERIOD_MS);
-        pStrip->clear(pStrip, 50);
-        vTaskDelay(CONFIG_BLINK_PERIOD / portTICK_PERIOD_MS);
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        xSemaphoreTake(strip_lock, portMAX_DELAY);
+        if (bits & LEDMATRIX_NOTIFY_OVERLAY)
+            apply_overlay();
+        if (bits & LEDMATRIX_NOTIFY_TICK)
+            scroll_tick();
+        xSemaphoreGive(strip_lock);
+    }
+}
+
+// esp_timer task: never blocks, a tick still pending is merged with this one
+static void scroll_timer_cb(void *arg)
+{
+    xTaskNotify(anim_task, LEDMATRIX_NOTIFY_TICK, eSetBits);
+}
+
+void ledmatrix_init(void)
+{
+    const esp_timer_create_args_t args = {
+        .callback = &scroll_timer_cb,
+        .name = "ledmatrix",
+    };
+
+    strip_lock = xSemaphoreCreateMutex();
+    pStrip = led_strip_init(CONFIG_BLINK_LED_RMT_CHANNEL, BLINK_GPIO, LEDMATRIX_NUM_PIXELS);
+    pStrip->clear(pStrip, 50);
+
+    xTaskCreate(&ledmatrix_task, "ledmatrix", LEDMATRIX_TASK_STACK_SIZE, NULL, LEDMATRIX_TASK_PRIORITY, &anim_task);
+    ESP_ERROR_CHECK(esp_timer_create(&args, &scroll_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(scroll_timer, SCROLL_TICK_US));
+}
+
+static void draw_cell(int cell, int x, int y)
+{
+    uint8_t *p = canvas[y][x];
+
+    switch (cell)
+    {
+    case GRID_GREEN:
+        p[0] = 0;
+        p[1] = 32;
+        p[2] = 0;
+        break;
+
+    case GRID_YELLOW:
+        p[0] = 32;
+        p[1] = 32;
+        p[2] = 0;
+        break;
+
+    case GRID_BLACK:
+    case GRID_WHITE:
+    default:
+        p[0] = 2;
+        p[1] = 2;
+        p[2] = 2;
+        break;
+    }
+}
+
+static void draw_grid(grid_t grid, int x0, int y0)
+{
+    int row, col;
+
+    for (row = 0; row < grid_rows(grid); row++)
+        for (col = 0; col < GRID_COLS; col++)
+            draw_cell(grid_cell(grid, row, col), x0 + col, y0 + row);
+}
+
+// grid g of the multi-grid board
+static void draw_board_grid(int g, int x0, int y0)
+{
+    int row, col;
+
+    for (row = 0; row < board.rows[g]; row++)
+        for (col = 0; col < GRID_COLS; col++)
+            draw_cell(grid_board_cell(&board, g, row, col), x0 + col, y0 + row);
+}
+
+static void add_stop(int x, int y)
+{
+    if (x > canvas_w - LEDMATRIX_WIDTH)
+        x = canvas_w - LEDMATRIX_WIDTH;
+    if (y > canvas_h - LEDMATRIX_HEIGHT)
+        y = canvas_h - LEDMATRIX_HEIGHT;
+    if (x < 0)
+        x = 0;
+    if (y < 0)
+        y = 0;
+
+    if (num_stops > 0 && stops[num_stops - 1].x == x && stops[num_stops - 1].y == y)
+        return;
+    stops[num_stops].x = x;
+    stops[num_stops].y = y;
+    num_stops++;
+}
+
+// single grids side by side, bottom-aligned; the viewport scrolls up and
+// down if one is taller than the panel
+static void layout_recent(void)
+{
+    int s, x0 = (LEDMATRIX_WIDTH - LEDMATRIX_SLOTS * GRID_COLS) / 2;
+
+    canvas_w = LEDMATRIX_WIDTH;
+    canvas_h = LEDMATRIX_HEIGHT;
+    for (s = 0; s < LEDMATRIX_SLOTS; s++)
+        if (grid_rows(recent[s]) > canvas_h)
+            canvas_h = grid_rows(recent[s]);
+
+    for (s = 0; s < LEDMATRIX_SLOTS; s++)
+        draw_grid(recent[s], x0 + s * GRID_COLS, canvas_h - grid_rows(recent[s]));
+
+    add_stop(0, 0);
+    add_stop(0, canvas_h - LEDMATRIX_HEIGHT);
+}
+
+// blocks of up to board.cols grids one below the other, each as tall as its
+// tallest grid; the viewport visits every grid, and pages down the tall ones
+static void layout_multi(void)
+{
+    int block_y[LEDMATRIX_MAX_BLOCKS], block_h[LEDMATRIX_MAX_BLOCKS];
+    int blocks = (board.num_grids + board.cols - 1) / board.cols;
+    int i, b, x, y, rows;
+
+    for (b = 0; b < blocks; b++)
+    {
+        block_h[b] = 1;
+        for (i = b * board.cols; i < (b + 1) * board.cols && i < board.num_grids; i++)
+            if (board.rows[i] > block_h[b])
+                block_h[b] = board.rows[i];
+        block_y[b] = b == 0 ? 0 : block_y[b - 1] + block_h[b - 1] + 1;
+    }
+
+    canvas_w = board.cols * (GRID_COLS + 1) - 1;
+    canvas_h = block_y[blocks - 1] + block_h[blocks - 1];
+    if (canvas_w < LEDMATRIX_WIDTH)
+        canvas_w = LEDMATRIX_WIDTH;
+    if (canvas_h < LEDMATRIX_HEIGHT)
+        canvas_h = LEDMATRIX_HEIGHT;
+
+    for (i = 0; i < board.num_grids; i++)
+    {
+        b = i / board.cols;
+        x = (i % board.cols) * (GRID_COLS + 1);
+        rows = board.rows[i];
+        draw_board_grid(i, x, block_y[b]);
+        add_stop(x, block_y[b]);
+        for (y = block_y[b] + LEDMATRIX_HEIGHT; y < block_y[b] + rows - LEDMATRIX_HEIGHT; y += LEDMATRIX_HEIGHT)
+            add_stop(x, y);
+        if (rows > LEDMATRIX_HEIGHT)
+            add_stop(x, block_y[b] + rows - LEDMATRIX_HEIGHT);
     }
 }
+
+// lay out what is shown on the canvas and start from the first stop (strip_lock held)
+static void layout(void)
+{
+    memset(canvas, 0, sizeof(canvas));
+    num_stops = 0;
+
+    if (board.num_grids > 0)
+        layout_multi();
+    else
+        layout_recent();
+
+    // the animation tick takes it from here
+    view_x = stops[0].x;
+    view_y = stops[0].y;
+    next_stop = num_stops > 1 ? 1 : 0;
+    hold = SCROLL_HOLD_TICKS;
+
+    refresh_frame();
+}
+
+void ledmatrix_update(grid_t grid)
+{
+    char cells[GRID_COLS * GRID_MAX_ROWS + 1];
+
+    grid_decode(grid, cells);
+    ESP_LOGI(TAG, "showing %d-lines Wordle: %s", grid_rows(grid), cells);
+
+    xSemaphoreTake(strip_lock, portMAX_DELAY);
+
+    // the newest single grid enters on the right
+    memmove(recent, recent + 1, (LEDMATRIX_SLOTS - 1) * sizeof(grid_t));
+    recent[LEDMATRIX_SLOTS - 1] = grid;
+    board.num_grids = 0;
+    layout();
+
+    xSemaphoreGive(strip_lock);
+}
+
+void ledmatrix_show_board(const grid_board_t *b)
+{
+    int num_grids = b->num_grids, cols = b->cols, g, rows = 0;
+
+    if (cols < 1 || cols > LEDMATRIX_MAX_COLS)
+        cols = 1;
+    if (num_grids > cols * LEDMATRIX_MAX_BLOCKS)
+        num_grids = cols * LEDMATRIX_MAX_BLOCKS;
+    for (g = 0; g < num_grids; g++)
+        if (b->rows[g] > rows)
+            rows = b->rows[g];
+
+    ESP_LOGI(TAG, "showing %d grids, %d wide, up to %d rows", num_grids, cols, rows);
+
+    xSemaphoreTake(strip_lock, portMAX_DELAY);
+
+    // (the canvas fits LEDMATRIX_MAX_BLOCKS blocks of GRID_BOARD_MAX_ROWS rows)
+    board = *b;
+    board.num_grids = num_grids;
+    board.cols = cols;
+    for (g = 0; g < num_grids; g++)
+        if (board.rows[g] > GRID_BOARD_MAX_ROWS)
+            board.rows[g] = GRID_BOARD_MAX_ROWS;
+    layout();
+
+    xSemaphoreGive(strip_lock);
+}
+
+void ledmatrix_redraw_grids(void)
+{
+    xSemaphoreTake(strip_lock, portMAX_DELAY);
+
+    if (board.num_grids > 0 || grid_rows(recent[LEDMATRIX_SLOTS - 1]) > 0)
+        layout();
+
+    xSemaphoreGive(strip_lock);
+}
+
+void ledmatrix_draw(const uint8_t pixels[LEDMATRIX_TILE_PIXELS][3])
+{
+    int i, x0 = (LEDMATRIX_WIDTH - LEDMATRIX_TILE) / 2, y0 = LEDMATRIX_HEIGHT - LEDMATRIX_TILE;
+
+    xSemaphoreTake(strip_lock, portMAX_DELAY);
+
+    canvas_w = LEDMATRIX_WIDTH;
+    canvas_h = LEDMATRIX_HEIGHT;
+    memset(canvas, 0, sizeof(canvas));
+    for (i = 0; i < LEDMATRIX_TILE_PIXELS; i++)
+        memcpy(canvas[y0 + i / LEDMATRIX_TILE][x0 + i % LEDMATRIX_TILE], pixels[i], 3);
+    num_stops = 0;
+    view_x = view_y = 0;
+
+    refresh_frame();
+
+    xSemaphoreGive(strip_lock);
+}
+
+void ledmatrix_set_overlay(int enable, uint8_t r, uint8_t g, uint8_t b)
+{
+    atomic_store(&overlay_req, (unsigned int)!!enable << 24 | r << 16 | g << 8 | b);
+    if (anim_task != NULL)
+        xTaskNotify(anim_task, LEDMATRIX_NOTIFY_OVERLAY, eSetBits);
+}
@@ -13,15 +13,62 @@
 #ifndef __LED_MATRIX_H__
 #define __LED_MATRIX_H__
 
+#include "sdkconfig.h"
 #include "driver/gpio.h"
 #include "led_strip.h"
+#include "grid.h"
 
 #define CONFIG_BLINK_LED_RMT_CHANNEL 1
 #define BLINK_GPIO 8
 #define CONFIG_BLINK_PERIOD 500
 
+// the animation task: moves the viewport one step per tick and draws the overlay
+#define LEDMATRIX_TASK_STACK_SIZE 2048
+
+// panel geometry (the wiring order is in the pixel map generated at build
+// time by gen_pixel_map.py); pixels are numbered row by row from the top left
+#define LEDMATRIX_WIDTH CONFIG_LEDMATRIX_WIDTH
+#define LEDMATRIX_HEIGHT CONFIG_LEDMATRIX_HEIGHT
+#define LEDMATRIX_NUM_PIXELS (LEDMATRIX_WIDTH * LEDMATRIX_HEIGHT)
+#define LEDMATRIX_CENTER (LEDMATRIX_HEIGHT / 2 * LEDMATRIX_WIDTH + LEDMATRIX_WIDTH / 2)
+
+// images drawn by the other display modes: one 5x5 tile
+#define LEDMATRIX_TILE 5
+#define LEDMATRIX_TILE_PIXELS (LEDMATRIX_TILE * LEDMATRIX_TILE)
+
+// grids are laid out on a virtual canvas: single grids side by side, as many
+// as fit the panel width (newest on the right); multi-grid results up to 2
+// wide, in up to 4 blocks one below the other (each as tall as its grids, up
+// to GRID_BOARD_MAX_ROWS), with a 1-pixel gap. The panel shows a viewport of
+// it, scrolled by the animation tick when the canvas is larger
+#define LEDMATRIX_SLOTS (LEDMATRIX_WIDTH / GRID_COLS)
+#define LEDMATRIX_MAX_COLS 2
+#define LEDMATRIX_MAX_BLOCKS 4
+#define LEDMATRIX_MAX_GRIDS (LEDMATRIX_MAX_COLS * LEDMATRIX_MAX_BLOCKS)
+#define LEDMATRIX_CANVAS_COLS (LEDMATRIX_MAX_COLS * (GRID_COLS + 1) - 1 > LEDMATRIX_WIDTH \
+                                   ? LEDMATRIX_MAX_COLS * (GRID_COLS + 1) - 1                \
+                                   : LEDMATRIX_WIDTH)
+#define LEDMATRIX_CANVAS_ROWS (LEDMATRIX_MAX_BLOCKS * (GRID_BOARD_MAX_ROWS + 1) - 1 > LEDMATRIX_HEIGHT \
+                                   ? LEDMATRIX_MAX_BLOCKS * (GRID_BOARD_MAX_ROWS + 1) - 1                \
+                                   : LEDMATRIX_HEIGHT)
+
 void ledmatrix_init(void);
-void ledmatrix_update(char *buf, int num_lines);
-void blink_red_forever(void);
+
+// show a single grid, next to the previous ones
+void ledmatrix_update(grid_t grid);
+
+// show the grids of a multi-grid result, board->cols of them side by side
+void ledmatrix_show_board(const grid_board_t *board);
+
+// show the grids again after another display mode (no-op if there are none)
+void ledmatrix_redraw_grids(void);
+
+// show a 5x5 image, row by row from the top left (other display modes),
+// centered at the bottom of the panel
+void ledmatrix_draw(const uint8_t pixels[LEDMATRIX_TILE_PIXELS][3]);
+
+// draw (or remove) a single-pixel overlay on the central LED, without touching the displayed Wordle
+// (never blocks, the LED matrix task draws it: safe from esp_timer callbacks)
+void ledmatrix_set_overlay(int enable, uint8_t r, uint8_t g, uint8_t b);
 
 #endif /* __LED_MATRIX_H__ */
@@ -12,6 +12,7 @@
 
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 
 #include "main.h"
@@ -19,9 +20,48 @@
 #include "ledmatrix.h"
 #include "twitter.h"
 #include "wordle.h"
+#include "indicator.h"
+#include "metrics.h"
+#include "status_server.h"
+#include "tweetlog.h"
+#include "memprof.h"
+#include "stats.h"
+#include "display.h"
+#include "history.h"
+#include "capture.h"
+#include "trace.h"
 
 const char *TAG = "wordle";
 
+static const char *boot_mark_names[BOOT_MARK_NUM] = {"IP", "TLS", "first frame"};
+static int64_t boot_mark_us[BOOT_MARK_NUM];
+
+void boot_mark(boot_mark_t mark)
+{
+  // only the first occurrence after boot counts
+  if (boot_mark_us[mark] != 0)
+    return;
+  boot_mark_us[mark] = esp_timer_get_time();
+
+  ESP_LOGI(TAG, "boot-to-%s: %lld ms", boot_mark_names[mark], boot_mark_us[mark] / 1000);
+
+  if (mark == BOOT_MARK_FIRST_FRAME)
+    ESP_LOGI(TAG, "startup timing: IP %lld ms, TLS %lld ms, first frame %lld ms",
+             boot_mark_us[BOOT_MARK_IP] / 1000,
+             boot_mark_us[BOOT_MARK_TLS] / 1000,
+             boot_mark_us[BOOT_MARK_FIRST_FRAME] / 1000);
+}
+
+// repaint the grids shown before the reboot, oldest first, as many as the matrix holds
+static void show_saved_grids(void)
+{
+  history_entry_t entries[LEDMATRIX_SLOTS];
+  int n = history_get(entries, LEDMATRIX_SLOTS);
+
+  while (n-- > 0)
+    ledmatrix_update(entries[n].grid);
+}
+
 void app_main(void)
 {
   // Initialize NVS
@@ -33,16 +73,32 @@ void app_main(void)
   }
   ESP_ERROR_CHECK(ret);
 
+  metrics_init();
+  stats_init();
+  tweetlog_init();
+  trace_init();
+  capture_init();
+  history_init();
   ledmatrix_init();
+  show_saved_grids();
+  display_init();
+  indicator_init();
+
+  // start connecting to Wi-Fi (retries in the background, status shown on the central LED)
+  wifi_init();
 
-  ret = wifi_init();
-  // couldn't connect or get an IP
-  if (!ret)
-    blink_red_forever();
+#ifdef CONFIG_STATUS_SERVER
+  status_server_init();
+#endif
 
-  // open TLS connection to Twitter API endpoint
+  // prepare the TLS context while the station associates, then open
+  // the TLS connection to the Twitter API endpoint
   twitter_api_init();
 
-  // run application (this never returns)
+#ifdef CONFIG_MEMPROF
+  memprof_init();
+#endif
+
+  // start the parser and renderer tasks (the main task ends here)
   wordle();
 }
@@ -15,4 +15,15 @@
 
 extern const char *TAG;
 
+// startup milestones, timed from boot and logged on every boot
+typedef enum
+{
+    BOOT_MARK_IP,          // got an IP address
+    BOOT_MARK_TLS,         // TLS handshake with the API server completed
+    BOOT_MARK_FIRST_FRAME, // first Wordle shown on the LED matrix
+    BOOT_MARK_NUM,
+} boot_mark_t;
+
+void boot_mark(boot_mark_t mark);
+
 #endif /* __MAIN_H__ **/
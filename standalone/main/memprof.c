@@ -0,0 +1,168 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "memprof.h"
+#include "twitter.h"
+#include "tweetlog.h"
+#include "history.h"
+#include "stats.h"
+#include "ledmatrix.h"
+#include "metrics.h"
+#include "trace.h"
+#include "wifi.h"
+
+#include <string.h>
+#include "lwjson/lwjson.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+// records replayed by the burst, shaped like the filtered stream's output
+static const char *burst_records[] = {
+    "{\"data\":{\"id\":\"1490000000000000001\",\"text\":\"Wordle 230 3/6\\n\\n"
+    "\xe2\xac\x9b\xf0\x9f\x9f\xa8\xe2\xac\x9b\xe2\xac\x9b\xe2\xac\x9b\\n"
+    "\xf0\x9f\x9f\xa9\xe2\xac\x9b\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa8\xe2\xac\x9b\\n"
+    "\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\"},"
+    "\"matching_rules\":[{\"id\":\"1489000000000000000\",\"tag\":\"wordle\"}]}\r\n",
+
+    "{\"data\":{\"id\":\"1490000000000000002\",\"text\":\"Wordle 230 6/6\\n\\n"
+    "\xe2\xac\x9c\xe2\xac\x9c\xe2\xac\x9c\xe2\xac\x9c\xf0\x9f\x9f\xa8\\n"
+    "\xe2\xac\x9c\xf0\x9f\x9f\xa8\xe2\xac\x9c\xe2\xac\x9c\xe2\xac\x9c\\n"
+    "\xe2\xac\x9c\xe2\xac\x9c\xf0\x9f\x9f\xa9\xe2\xac\x9c\xe2\xac\x9c\\n"
+    "\xf0\x9f\x9f\xa9\xe2\xac\x9c\xf0\x9f\x9f\xa9\xe2\xac\x9c\xe2\xac\x9c\\n"
+    "\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xe2\xac\x9c\xf0\x9f\x9f\xa9\\n"
+    "\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9\xf0\x9f\x9f\xa9"
+    " #wordle #dailychallenge\"},"
+    "\"matching_rules\":[{\"id\":\"1489000000000000000\",\"tag\":\"wordle\"}]}\r\n",
+
+    "{\"data\":{\"id\":\"1490000000000000003\",\"text\":\"I can't stop playing wordle, "
+    "it's the best part of my morning. Anyone else stuck on today's one?\"},"
+    "\"matching_rules\":[{\"id\":\"1489000000000000000\",\"tag\":\"wordle\"}]}\r\n",
+
+    "{\"data\":{\"id\":\"1490000000000000004\",\"text\":\"Wordle 230 X/6\\n\\n"
+    "\xf0\x9f\x9f\xa8\xe2\xac\x9b\xe2\xac\x9b\xe2\xac\x9b\xe2\xac\x9b\\n"
+    "\xe2\xac\x9b\xf0\x9f\x9f\xa9\xe2\xac\x9b\xe2\xac\x9b\xf0\x9f\x9f\xa8\"},"
+    "\"matching_rules\":[{\"id\":\"1489000000000000999\",\"tag\":\"other\"}]}\r\n",
+};
+
+typedef struct
+{
+    const char *name;
+    int stack_size;
+} task_budget_t;
+
+static const task_budget_t tasks[] = {
+    {"main", CONFIG_ESP_MAIN_TASK_STACK_SIZE},
+    {"parser", CONFIG_PARSER_TASK_STACK_SIZE},
+    {"renderer", CONFIG_RENDER_TASK_STACK_SIZE},
+    {"https_stream_task", CONFIG_STREAM_TASK_STACK_SIZE},
+#ifndef CONFIG_TWEETLOG_OFF
+    {"tweetlog", TWEETLOG_STACK_SIZE},
+#endif
+#if CONFIG_METRICS_LOG_PERIOD > 0
+    {"metrics_log", METRICS_LOG_STACK_SIZE},
+#endif
+#ifdef CONFIG_TRACE
+    {"trace_dump", TRACE_DUMP_STACK_SIZE},
+#endif
+    {"history_flush", HISTORY_FLUSH_STACK_SIZE},
+#ifdef CONFIG_ESP_WIFI_FAST_RECONNECT
+    {"wifi_nvs", WIFI_NVS_STACK_SIZE},
+#endif
+    {"stats_flush", STATS_FLUSH_STACK_SIZE},
+    {"ledmatrix", LEDMATRIX_TASK_STACK_SIZE},
+    {"esp_timer", CONFIG_ESP_TIMER_TASK_STACK_SIZE},
+    {"httpd", 4096},
+};
+
+#if defined(CONFIG_MBEDTLS_ASYMMETRIC_CONTENT_LEN)
+#define TLS_RECORD_BUFS (CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN + CONFIG_MBEDTLS_SSL_OUT_CONTENT_LEN)
+#elif defined(CONFIG_MBEDTLS_SSL_MAX_CONTENT_LEN)
+#define TLS_RECORD_BUFS (2 * CONFIG_MBEDTLS_SSL_MAX_CONTENT_LEN)
+#else
+#define TLS_RECORD_BUFS 0
+#endif
+
+void memprof_report(void)
+{
+    static metrics_snapshot_t snap;
+    TaskHandle_t task;
+    int i, free_stack;
+
+    metrics_snapshot(&snap);
+
+    ESP_LOGI(TAG, "=== RAM budget (bytes) ===");
+
+    ESP_LOGI(TAG, "task stacks:      %-18s %6s %6s %6s", "task", "size", "used", "free");
+    for (i = 0; i < (int)(sizeof(tasks) / sizeof(tasks[0])); i++)
+    {
+        task = xTaskGetHandle(tasks[i].name);
+        if (task == NULL)
+            continue;
+        free_stack = uxTaskGetStackHighWaterMark(task);
+        ESP_LOGI(TAG, "                  %-18s %6d %6d %6d", tasks[i].name, tasks[i].stack_size,
+                 tasks[i].stack_size - free_stack, free_stack);
+    }
+
+    ESP_LOGI(TAG, "stream:           read size %d, stream ring %d (heap), high water %u",
+             CONFIG_STREAM_READ_BUF_SIZE, CONFIG_STREAM_BUF_SIZE,
+             (unsigned)snap.gauges[METRIC_STREAM_BUF_HIGH_WATER]);
+    ESP_LOGI(TAG, "TLS:              record buffers %d (heap)", TLS_RECORD_BUFS);
+    ESP_LOGI(TAG, "parser:           tweet buf %d (stack), %d tokens %d (static)",
+             CONFIG_TWEET_BUF_LEN, CONFIG_JSON_MAX_TOKENS,
+             (int)(CONFIG_JSON_MAX_TOKENS * sizeof(lwjson_token_t)));
+#ifndef CONFIG_TWEETLOG_OFF
+    ESP_LOGI(TAG, "tweet log:        ring %d (heap), dropped %u", CONFIG_TWEETLOG_BUF_SIZE,
+             (unsigned)snap.counters[METRIC_LOG_DROPPED]);
+#endif
+#ifdef CONFIG_TRACE
+    ESP_LOGI(TAG, "trace:            ring %d (static)", (int)(CONFIG_TRACE_LEN * sizeof(trace_event_t)));
+#endif
+    ESP_LOGI(TAG, "history:          %d (static)", (int)(CONFIG_GRID_HISTORY_LEN * sizeof(history_entry_t)));
+    ESP_LOGI(TAG, "metrics:          snapshot %d", (int)sizeof(metrics_snapshot_t));
+    ESP_LOGI(TAG, "heap:             free %u, minimum free %u, largest free block %u",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+}
+
+static void memprof_task(void *pvParameters)
+{
+    int i, n;
+    const char *r;
+
+    // let the rest of the startup settle
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_MEMPROF_START_DELAY_MS));
+
+    // the stream task isn't started in this mode, so this is the ring's only producer
+    ESP_LOGI(TAG, "memory profile: replaying a burst of %d records", CONFIG_MEMPROF_BURST_RECORDS);
+    for (i = 0; i < CONFIG_MEMPROF_BURST_RECORDS; i++)
+    {
+        r = burst_records[i % (sizeof(burst_records) / sizeof(burst_records[0]))];
+        for (n = strlen(r); n > 0;)
+            n -= bytering_send(stream_ring, r + strlen(r) - n, n, portMAX_DELAY);
+    }
+
+    // wait for the parser to drain the stream ring
+    while (bytering_bytes_available(stream_ring) > 0)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    memprof_report();
+    vTaskDelete(NULL);
+}
+
+void memprof_init(void)
+{
+    xTaskCreate(&memprof_task, "memprof", 3072, NULL, STREAM_TASK_PRIORITY, NULL);
+}
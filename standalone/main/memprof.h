@@ -0,0 +1,22 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __MEMPROF_H__
+#define __MEMPROF_H__
+
+// memory-profile mode: replay a burst of records through the parser, then
+// log stack high-water marks, heap minimums and a per-subsystem RAM budget
+// (the burst stands in for the stream task, which isn't started)
+void memprof_init(void);
+
+// log the RAM budget report now
+void memprof_report(void);
+
+#endif /* __MEMPROF_H__ **/
@@ -0,0 +1,253 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "metrics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *counter_names[METRIC_COUNTER_NUM] = {
+    [METRIC_BYTES_READ] = "bytes_read",
+    [METRIC_STREAM_WAKEUPS] = "stream_wakeups",
+    [METRIC_RECORDS_FRAMED] = "records",
+    [METRIC_RECORDS_TOO_LONG] = "too_long",
+    [METRIC_JSON_PARSE_FAILED] = "json_fail",
+    [METRIC_UNTAGGED] = "untagged",
+    [METRIC_NOT_WORDLE] = "not_wordle",
+    [METRIC_MULTI_GRID] = "multi_grid",
+    [METRIC_FRAMES_RENDERED] = "frames",
+    [METRIC_STREAM_RECONNECTS] = "reconnects",
+    [METRIC_LOG_DROPPED] = "log_dropped",
+    [METRIC_CAPTURE_DROPPED] = "capture_dropped",
+    [METRIC_GRIDS_DROPPED] = "grids_dropped",
+    [METRIC_GRIDS_SUPPRESSED] = "grids_suppressed",
+    [METRIC_GRIDS_SHED] = "grids_shed",
+};
+
+static const char *gauge_names[METRIC_GAUGE_NUM] = {
+    [METRIC_STREAM_BUF_HIGH_WATER] = "stream_buf_hw",
+    [METRIC_GRID_QUEUE_HIGH_WATER] = "grid_queue_hw",
+};
+
+static const char *hist_names[METRIC_HIST_NUM] = {
+    [METRIC_LAT_ENQUEUE] = "enqueue",
+    [METRIC_LAT_PARSE] = "parse",
+    [METRIC_LAT_MATCH] = "match",
+    [METRIC_LAT_RENDER] = "render",
+    [METRIC_LAT_RECORD] = "record",
+    [METRIC_LAT_ARRIVAL] = "arrival",
+    [METRIC_LAT_E2E] = "e2e",
+};
+
+// The ESP32-C3 (RV32) has no 64-bit atomics, and libatomic would take a lock
+// for them: the sum is kept as two 32-bit halves instead. Every histogram has
+// a single writer (the stage it times), which makes sum_seq odd while it
+// updates them; readers retry until they see the same even value around their
+// reads (a sequence lock without a lock for the writer).
+typedef struct
+{
+    atomic_uint_least32_t count;
+    atomic_uint_least32_t sum_seq;
+    atomic_uint_least32_t sum_lo, sum_hi;
+    atomic_uint_least32_t max_us;
+    atomic_uint_least32_t buckets[METRIC_HIST_BUCKETS];
+} histogram_t;
+
+static atomic_uint_least32_t counters[METRIC_COUNTER_NUM];
+static atomic_uint_least32_t gauges[METRIC_GAUGE_NUM];
+static histogram_t hists[METRIC_HIST_NUM];
+
+static void atomic_max(atomic_uint_least32_t *a, uint32_t value)
+{
+    uint32_t old = atomic_load_explicit(a, memory_order_relaxed);
+
+    while (value > old &&
+           !atomic_compare_exchange_weak_explicit(a, &old, value, memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+void metrics_inc(metric_counter_t counter)
+{
+    atomic_fetch_add_explicit(&counters[counter], 1, memory_order_relaxed);
+}
+
+void metrics_add(metric_counter_t counter, uint32_t n)
+{
+    atomic_fetch_add_explicit(&counters[counter], n, memory_order_relaxed);
+}
+
+void metrics_gauge_max(metric_gauge_t gauge, uint32_t value)
+{
+    atomic_max(&gauges[gauge], value);
+}
+
+void metrics_observe_us(metric_hist_t hist, int64_t us)
+{
+    histogram_t *h = &hists[hist];
+    uint32_t v = us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+    uint32_t seq, lo;
+    int b = 0;
+
+    // bucket = number of significant bits
+    while (v >> b && b < METRIC_HIST_BUCKETS - 1)
+        b++;
+
+    atomic_fetch_add_explicit(&h->buckets[b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+    atomic_max(&h->max_us, v);
+
+    // (single writer: plain loads and stores, no read-modify-write needed)
+    seq = atomic_load_explicit(&h->sum_seq, memory_order_relaxed);
+    atomic_store_explicit(&h->sum_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    lo = atomic_load_explicit(&h->sum_lo, memory_order_relaxed);
+    atomic_store_explicit(&h->sum_lo, lo + v, memory_order_relaxed);
+    if (lo + v < lo)
+        atomic_store_explicit(&h->sum_hi, atomic_load_explicit(&h->sum_hi, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+    atomic_store_explicit(&h->sum_seq, seq + 2, memory_order_release);
+}
+
+// the 64-bit sum of a histogram, consistent with itself
+static uint64_t hist_sum(histogram_t *h)
+{
+    uint32_t seq, lo, hi;
+
+    while (1)
+    {
+        seq = atomic_load_explicit(&h->sum_seq, memory_order_acquire);
+        if (seq & 1)
+        {
+            // the writer was preempted halfway: let it finish
+            vTaskDelay(1);
+            continue;
+        }
+        lo = atomic_load_explicit(&h->sum_lo, memory_order_relaxed);
+        hi = atomic_load_explicit(&h->sum_hi, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&h->sum_seq, memory_order_relaxed) == seq)
+            return (uint64_t)hi << 32 | lo;
+    }
+}
+
+void metrics_snapshot(metrics_snapshot_t *snap)
+{
+    int i, j;
+
+    snap->timestamp_us = esp_timer_get_time();
+
+    for (i = 0; i < METRIC_COUNTER_NUM; i++)
+        snap->counters[i] = atomic_load_explicit(&counters[i], memory_order_relaxed);
+
+    for (i = 0; i < METRIC_GAUGE_NUM; i++)
+        snap->gauges[i] = atomic_load_explicit(&gauges[i], memory_order_relaxed);
+
+    for (i = 0; i < METRIC_HIST_NUM; i++)
+    {
+        snap->hists[i].count = atomic_load_explicit(&hists[i].count, memory_order_relaxed);
+        snap->hists[i].sum_us = hist_sum(&hists[i]);
+        snap->hists[i].max_us = atomic_load_explicit(&hists[i].max_us, memory_order_relaxed);
+        for (j = 0; j < METRIC_HIST_BUCKETS; j++)
+            snap->hists[i].buckets[j] = atomic_load_explicit(&hists[i].buckets[j], memory_order_relaxed);
+    }
+}
+
+// append to buf, tracking the length snprintf would have produced
+#define APPEND(...)                                                               \
+    do                                                                            \
+    {                                                                             \
+        int __n = snprintf(buf + (n < (int)len ? n : (int)len),                   \
+                           n < (int)len ? len - n : 0, __VA_ARGS__);              \
+        if (__n > 0)                                                              \
+            n += __n;                                                             \
+    } while (0)
+
+int metrics_serialize(const metrics_snapshot_t *snap, char *buf, size_t len)
+{
+    int n = 0;
+    int i, j, last;
+
+    APPEND("{\"t\":%lld,\"c\":{", (long long)(snap->timestamp_us / 1000));
+    for (i = 0; i < METRIC_COUNTER_NUM; i++)
+        APPEND("%s\"%s\":%u", i ? "," : "", counter_names[i], (unsigned)snap->counters[i]);
+
+    APPEND("},\"g\":{");
+    for (i = 0; i < METRIC_GAUGE_NUM; i++)
+        APPEND("%s\"%s\":%u", i ? "," : "", gauge_names[i], (unsigned)snap->gauges[i]);
+
+    // histograms: count, sum, max, and buckets up to the last non-empty one
+    APPEND("},\"h\":{");
+    for (i = 0; i < METRIC_HIST_NUM; i++)
+    {
+        const metric_hist_snapshot_t *h = &snap->hists[i];
+
+        APPEND("%s\"%s\":[%u,%llu,%u,[", i ? "," : "", hist_names[i],
+               (unsigned)h->count, (unsigned long long)h->sum_us, (unsigned)h->max_us);
+        for (last = METRIC_HIST_BUCKETS - 1; last >= 0 && h->buckets[last] == 0; last--)
+            ;
+        for (j = 0; j <= last; j++)
+            APPEND("%s%u", j ? "," : "", (unsigned)h->buckets[j]);
+        APPEND("]]");
+    }
+    APPEND("}}");
+
+    return n;
+}
+
+#if CONFIG_METRICS_LOG_PERIOD > 0
+// a low priority task rather than an esp_timer callback: formatting and
+// logging the snapshot would hold up every other timer
+static void metrics_log_task(void *pvParameters)
+{
+    static metrics_snapshot_t snap;
+    static char *buf;
+    static int size;
+    TickType_t last_wake = xTaskGetTickCount();
+    char *grown;
+    int n;
+
+    while (1)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_METRICS_LOG_PERIOD * 1000));
+
+        // the buffer grows with the histograms, the log is never truncated
+        metrics_snapshot(&snap);
+        n = metrics_serialize(&snap, NULL, 0);
+        if (n >= size)
+        {
+            grown = realloc(buf, n + 1);
+            if (grown == NULL)
+            {
+                ESP_LOGW(TAG, "metrics: no memory for %d bytes", n + 1);
+                continue;
+            }
+            buf = grown;
+            size = n + 1;
+        }
+        metrics_serialize(&snap, buf, size);
+        ESP_LOGI(TAG, "metrics: %s", buf);
+    }
+}
+#endif
+
+void metrics_init(void)
+{
+#if CONFIG_METRICS_LOG_PERIOD > 0
+    // lowest priority above idle, like the tweet log
+    xTaskCreate(&metrics_log_task, "metrics_log", METRICS_LOG_STACK_SIZE, NULL, 1, NULL);
+#endif
+}
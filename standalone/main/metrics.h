@@ -0,0 +1,99 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// the periodic log's task (see METRICS_LOG_PERIOD)
+#define METRICS_LOG_STACK_SIZE 2560
+
+// event counters
+typedef enum
+{
+    METRIC_BYTES_READ,         // bytes returned by mbedtls_ssl_read()
+    METRIC_STREAM_WAKEUPS,     // reads of the stream ring by the parser
+    METRIC_RECORDS_FRAMED,     // newline-delimited records handed to the parser
+    METRIC_RECORDS_TOO_LONG,   // records dropped because they don't fit the record buffer
+    METRIC_JSON_PARSE_FAILED,  // records lwjson could not parse
+    METRIC_UNTAGGED,           // records without the Wordle rule tag
+    METRIC_NOT_WORDLE,         // tagged records without a (solved) Wordle grid
+    METRIC_MULTI_GRID,         // results with several grids (Dordle, Quordle, ...)
+    METRIC_FRAMES_RENDERED,    // grids pushed to the LED matrix
+    METRIC_STREAM_RECONNECTS,  // restarts of the HTTPS streaming connection
+    METRIC_LOG_DROPPED,        // tweet log lines dropped because the console lagged
+    METRIC_CAPTURE_DROPPED,    // stream capture chunks dropped (console or flash lagged, flash full)
+    METRIC_GRIDS_DROPPED,      // grids dropped because the renderer lagged
+    METRIC_GRIDS_SUPPRESSED,   // grids not shown because they were shown recently
+    METRIC_GRIDS_SHED,         // grids not picked for their dwell window
+    METRIC_COUNTER_NUM,
+} metric_counter_t;
+
+// gauges tracking a maximum
+typedef enum
+{
+    METRIC_STREAM_BUF_HIGH_WATER, // most bytes ever waiting in the stream ring
+    METRIC_GRID_QUEUE_HIGH_WATER, // most grids ever waiting for the renderer
+    METRIC_GAUGE_NUM,
+} metric_gauge_t;
+
+// latency histograms
+typedef enum
+{
+    METRIC_LAT_ENQUEUE, // wait for room in the stream ring before a TLS read (back-pressure)
+    METRIC_LAT_PARSE,   // lwjson_parse() of one record
+    METRIC_LAT_MATCH,   // rule tag check and grid extraction
+    METRIC_LAT_RENDER,  // ledmatrix_update() / ledmatrix_show_board()
+    METRIC_LAT_RECORD,  // record parsed to grid shown (includes queueing and dwell)
+    METRIC_LAT_ARRIVAL, // tweet created_at to record parsed (Twitter + network)
+    METRIC_LAT_E2E,     // tweet created_at to grid shown on the LEDs
+    METRIC_HIST_NUM,
+} metric_hist_t;
+
+// histogram bucket i counts latencies in [2^(i-1), 2^i) us (bucket 0: < 1 us),
+// the last bucket also counts everything above
+#define METRIC_HIST_BUCKETS 27
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t buckets[METRIC_HIST_BUCKETS];
+} metric_hist_snapshot_t;
+
+typedef struct
+{
+    int64_t timestamp_us;
+    uint32_t counters[METRIC_COUNTER_NUM];
+    uint32_t gauges[METRIC_GAUGE_NUM];
+    metric_hist_snapshot_t hists[METRIC_HIST_NUM];
+} metrics_snapshot_t;
+
+void metrics_init(void);
+
+// lock-free updates, safe from any task (but each histogram must be fed by a
+// single task: the stage it times)
+void metrics_inc(metric_counter_t counter);
+void metrics_add(metric_counter_t counter, uint32_t n);
+void metrics_gauge_max(metric_gauge_t gauge, uint32_t value);
+void metrics_observe_us(metric_hist_t hist, int64_t us);
+
+// copy all metrics (each value is read atomically, the set as a whole is not;
+// from a task, it may wait a tick for a histogram's writer)
+void metrics_snapshot(metrics_snapshot_t *snap);
+
+// serialize a snapshot as compact JSON, returns the length (as snprintf:
+// the output was truncated if it is len or more, buf may be NULL if len is 0)
+int metrics_serialize(const metrics_snapshot_t *snap, char *buf, size_t len);
+
+#endif /* __METRICS_H__ **/
@@ -0,0 +1,228 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "stats.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+// distributions are saved at most this often, and only if they changed
+#define STATS_FLUSH_PERIOD_US ((uint64_t)CONFIG_STATS_FLUSH_PERIOD * 1000000)
+
+#define STATS_NVS_NAMESPACE "stats"
+#define STATS_NVS_KEY "puzzles"
+
+// a newer puzzle becomes current after this many results (so that a single
+// Tweet with a bogus number can't reset the distributions)
+#define STATS_ROLLOVER_RESULTS 3
+
+// current and previous puzzle, guarded by a spinlock
+static stats_puzzle_t puzzles[2];
+static stats_puzzle_t pending; // results of a newer puzzle, until it becomes current
+static int pending_results;
+static int dirty;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t flush_task;
+
+static int parse_at(const char *p, wordle_header_t *header)
+{
+    uint32_t puzzle = 0;
+    int digits = 0;
+
+    // puzzle number, possibly with thousands separators
+    for (; (*p >= '0' && *p <= '9') || ((*p == ',' || *p == '.') && digits > 0); p++)
+    {
+        if (*p == ',' || *p == '.')
+            continue;
+        puzzle = puzzle * 10 + (*p - '0');
+        if (++digits > 5)
+            return 0;
+    }
+    if (digits == 0 || puzzle == 0 || puzzle > UINT16_MAX || *p++ != ' ')
+        return 0;
+
+    if (*p >= '1' && *p <= '6')
+        header->score = *p - '0';
+    else if (*p == 'X')
+        header->score = 0;
+    else
+        return 0;
+    if (p[1] != '/' || p[2] != '6')
+        return 0;
+
+    header->puzzle = puzzle;
+    header->hard = p[3] == '*';
+
+    return 1;
+}
+
+int stats_parse_header(const char *text, wordle_header_t *header)
+{
+    const char *p;
+
+    for (p = strstr(text, "Wordle "); p != NULL; p = strstr(p + 1, "Wordle "))
+    {
+        if (parse_at(p + 7, header))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void add_result(stats_puzzle_t *s, const wordle_header_t *header)
+{
+    s->counts[header->score]++;
+    if (header->hard)
+        s->hard++;
+}
+
+void stats_add(const wordle_header_t *header)
+{
+    portENTER_CRITICAL(&stats_mux);
+
+    if (header->puzzle == puzzles[0].puzzle || puzzles[0].puzzle == 0)
+    {
+        puzzles[0].puzzle = header->puzzle;
+        add_result(&puzzles[0], header);
+        dirty = 1;
+    }
+    else if (header->puzzle == puzzles[1].puzzle)
+    {
+        add_result(&puzzles[1], header);
+        dirty = 1;
+    }
+    else if (header->puzzle > puzzles[0].puzzle)
+    {
+        // roll over once the new puzzle shows up repeatedly
+        if (header->puzzle != pending.puzzle)
+        {
+            memset(&pending, 0, sizeof(stats_puzzle_t));
+            pending.puzzle = header->puzzle;
+            pending_results = 0;
+        }
+        add_result(&pending, header);
+        if (++pending_results >= STATS_ROLLOVER_RESULTS)
+        {
+            puzzles[1] = puzzles[0];
+            puzzles[0] = pending;
+            pending.puzzle = 0;
+            dirty = 1;
+        }
+    }
+
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void stats_get(stats_puzzle_t stats[2])
+{
+    portENTER_CRITICAL(&stats_mux);
+    memcpy(stats, puzzles, sizeof(puzzles));
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void stats_draw(uint8_t pixels[LEDMATRIX_TILE_PIXELS][3])
+{
+    stats_puzzle_t s[2];
+    uint32_t bars[5], max = 0;
+    int col, row, height;
+
+    stats_get(s);
+
+    // columns: 1-2 guesses, 3, 4, 5, 6 (failures are not shown)
+    bars[0] = s[0].counts[1] + s[0].counts[2];
+    for (col = 1; col < 5; col++)
+        bars[col] = s[0].counts[col + 2];
+    for (col = 0; col < 5; col++)
+        max = bars[col] > max ? bars[col] : max;
+
+    memset(pixels, 0, LEDMATRIX_TILE_PIXELS * 3);
+    for (col = 0; col < 5; col++)
+    {
+        // bars grow from the bottom row, scaled to the tallest one
+        height = max > 0 ? (bars[col] * 5 + max / 2) / max : 0;
+        if (height == 0 && bars[col] > 0)
+            height = 1;
+        for (row = 5 - height; row < 5; row++)
+            pixels[5 * row + col][1] = 32;
+    }
+}
+
+static void stats_flush(void)
+{
+    stats_puzzle_t s[2];
+    nvs_handle_t nvs;
+
+    portENTER_CRITICAL(&stats_mux);
+    if (!dirty)
+    {
+        portEXIT_CRITICAL(&stats_mux);
+        return;
+    }
+    memcpy(s, puzzles, sizeof(puzzles));
+    dirty = 0;
+    portEXIT_CRITICAL(&stats_mux);
+
+    if (nvs_open(STATS_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+        return;
+    nvs_set_blob(nvs, STATS_NVS_KEY, s, sizeof(s));
+    nvs_commit(nvs);
+    nvs_close(nvs);
+
+    ESP_LOGD(TAG, "guess distributions saved");
+}
+
+// the NVS write can wait on the flash for a while, so it isn't done on the
+// esp_timer task: the timer only wakes this one up
+static void stats_flush_task(void *pvParameters)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        stats_flush();
+    }
+}
+
+static void stats_flush_cb(void *arg)
+{
+    xTaskNotifyGive(flush_task);
+}
+
+void stats_init(void)
+{
+    esp_timer_handle_t timer;
+    size_t len = sizeof(puzzles);
+    nvs_handle_t nvs;
+
+    if (nvs_open(STATS_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK)
+    {
+        if (nvs_get_blob(nvs, STATS_NVS_KEY, puzzles, &len) != ESP_OK || len != sizeof(puzzles))
+            memset(puzzles, 0, sizeof(puzzles));
+        nvs_close(nvs);
+    }
+    ESP_LOGI(TAG, "guess distributions: puzzle %u, previous %u", puzzles[0].puzzle, puzzles[1].puzzle);
+
+    // lowest priority above idle, like the tweet log
+    xTaskCreate(&stats_flush_task, "stats_flush", STATS_FLUSH_STACK_SIZE, NULL, 1, &flush_task);
+
+    // batch the writes: the flash sees one blob per period at most
+    const esp_timer_create_args_t args = {
+        .callback = &stats_flush_cb,
+        .name = "stats_flush",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, STATS_FLUSH_PERIOD_US));
+}
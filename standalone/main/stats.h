@@ -0,0 +1,54 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdint.h>
+
+#include "ledmatrix.h"
+
+// the task saving the distributions (see STATS_FLUSH_PERIOD)
+#define STATS_FLUSH_STACK_SIZE 3072
+
+// score 0 is a failed puzzle ("X/6"), 1 to 6 the number of guesses
+#define STATS_SCORES 7
+
+// result header of a shared Wordle, e.g. "Wordle 1,234 3/6*"
+typedef struct
+{
+    uint16_t puzzle;
+    uint8_t score;
+    uint8_t hard; // '*' after the score
+} wordle_header_t;
+
+// guess distribution of one puzzle
+typedef struct
+{
+    uint16_t puzzle; // 0 if unused
+    uint16_t hard;   // results in hard mode
+    uint32_t counts[STATS_SCORES];
+} stats_puzzle_t;
+
+// find and parse the header in a Tweet's text, returns 1 if found
+int stats_parse_header(const char *text, wordle_header_t *header);
+
+// restore the distributions from NVS and start the periodic flush
+void stats_init(void);
+
+void stats_add(const wordle_header_t *header);
+
+// copy the current (stats[0]) and previous (stats[1]) puzzles
+void stats_get(stats_puzzle_t stats[2]);
+
+// draw the current distribution as bars, one column per score
+void stats_draw(uint8_t pixels[LEDMATRIX_TILE_PIXELS][3]);
+
+#endif /* __STATS_H__ **/
@@ -0,0 +1,205 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "status_server.h"
+#include "metrics.h"
+#include "history.h"
+#include "trace.h"
+#include "wifi.h"
+#include "wordle.h"
+#include "stats.h"
+#include "display.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_http_server.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+// below the parser and the renderer (and so the stream task), whatever
+// their configured priorities
+#define LOWER_PIPELINE_PRIORITY                                                  \
+    (CONFIG_PARSER_TASK_PRIORITY < CONFIG_RENDER_TASK_PRIORITY ? CONFIG_PARSER_TASK_PRIORITY \
+                                                                : CONFIG_RENDER_TASK_PRIORITY)
+#define STATUS_SERVER_TASK_PRIORITY (LOWER_PIPELINE_PRIORITY - 1)
+
+_Static_assert(STATUS_SERVER_TASK_PRIORITY >= 1, "the parser and the renderer must run above priority 1");
+
+// tasks whose stack high-water mark is reported
+static const char *task_names[] = {"https_stream_task", "parser", "renderer", "httpd", "esp_timer"};
+
+// everything below is built from snapshots: nothing here waits on the
+// parser or the stream task
+static esp_err_t status_get_handler(httpd_req_t *req)
+{
+    metrics_snapshot_t *snap;
+    // (static, not on the small httpd stack: handlers run one at a time)
+    static history_entry_t grids[CONFIG_GRID_HISTORY_LEN];
+    wifi_stats_t wifi;
+    TaskHandle_t task;
+    char *json = NULL;
+    char line[160];
+    char cells[GRID_COLS * GRID_MAX_ROWS + 1];
+    stats_puzzle_t puzzles[2];
+    int i, n, json_len, stream_bytes, grids_waiting;
+
+    // the metrics go out in the middle of the response, but they are
+    // serialized first (sized by a dry run) so that an error can still be sent
+    snap = malloc(sizeof(metrics_snapshot_t));
+    if (snap != NULL)
+    {
+        metrics_snapshot(snap);
+        json_len = metrics_serialize(snap, NULL, 0);
+        json = malloc(json_len + 1);
+    }
+    if (snap == NULL || json == NULL)
+    {
+        free(snap);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "out of memory");
+    }
+    if (metrics_serialize(snap, json, json_len + 1) != json_len)
+    {
+        free(snap);
+        free(json);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "metrics don't fit");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    snprintf(line, sizeof(line), "{\"uptime_ms\":%lld,\"heap\":{\"free\":%u,\"min_free\":%u},",
+             esp_timer_get_time() / 1000,
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+    httpd_resp_sendstr_chunk(req, line);
+
+    wifi_get_stats(&wifi);
+    snprintf(line, sizeof(line), "\"wifi\":{\"connected\":%d,\"disconnects\":%u,\"disconnected_ms\":%lld,\"availability\":%.4f},",
+             wifi.connected, (unsigned)wifi.disconnects, wifi.disconnected_us / 1000, wifi.availability);
+    httpd_resp_sendstr_chunk(req, line);
+
+    // current depth of the pipeline queues
+    wordle_queue_depths(&stream_bytes, &grids_waiting);
+    snprintf(line, sizeof(line), "\"queues\":{\"stream_bytes\":%d,\"grids\":%d},", stream_bytes, grids_waiting);
+    httpd_resp_sendstr_chunk(req, line);
+
+    // stack high-water marks, in bytes
+    httpd_resp_sendstr_chunk(req, "\"stack_free\":{");
+    for (i = 0, n = 0; i < (int)(sizeof(task_names) / sizeof(task_names[0])); i++)
+    {
+        task = xTaskGetHandle(task_names[i]);
+        if (task == NULL)
+            continue;
+        snprintf(line, sizeof(line), "%s\"%s\":%u", n++ ? "," : "", task_names[i],
+                 (unsigned)uxTaskGetStackHighWaterMark(task));
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    httpd_resp_sendstr_chunk(req, "},\"metrics\":");
+
+    httpd_resp_sendstr_chunk(req, json);
+
+    // share of grids not redrawn because they were shown recently
+    n = snap->counters[METRIC_FRAMES_RENDERED] + snap->counters[METRIC_GRIDS_SUPPRESSED];
+    snprintf(line, sizeof(line), ",\"suppression_rate\":%.4f",
+             n > 0 ? (double)snap->counters[METRIC_GRIDS_SUPPRESSED] / n : 0.0);
+    httpd_resp_sendstr_chunk(req, line);
+
+    // guess distributions of the current and previous puzzle ([X, 1, ..., 6])
+    stats_get(puzzles);
+    snprintf(line, sizeof(line), ",\"display_mode\":\"%s\",\"puzzles\":[", display_mode_name(display_get_mode()));
+    httpd_resp_sendstr_chunk(req, line);
+    for (i = 0; i < 2; i++)
+    {
+        snprintf(line, sizeof(line), "%s{\"puzzle\":%u,\"hard\":%u,\"dist\":[%u,%u,%u,%u,%u,%u,%u]}", i ? "," : "",
+                 puzzles[i].puzzle, puzzles[i].hard,
+                 (unsigned)puzzles[i].counts[0], (unsigned)puzzles[i].counts[1], (unsigned)puzzles[i].counts[2],
+                 (unsigned)puzzles[i].counts[3], (unsigned)puzzles[i].counts[4], (unsigned)puzzles[i].counts[5],
+                 (unsigned)puzzles[i].counts[6]);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    httpd_resp_sendstr_chunk(req, "]");
+
+    // recently displayed Wordles, newest first (age -1: shown before the last reboot)
+    httpd_resp_sendstr_chunk(req, ",\"grids\":[");
+    n = history_get(grids, CONFIG_GRID_HISTORY_LEN);
+    for (i = 0; i < n; i++)
+    {
+        grid_decode(grids[i].grid, cells);
+        snprintf(line, sizeof(line), "%s{\"age_ms\":%lld,\"game\":\"%s\",\"lines\":%d,\"grid\":\"%s\"}", i ? "," : "",
+                 grids[i].timestamp_us ? (esp_timer_get_time() - grids[i].timestamp_us) / 1000 : -1LL,
+                 gridscan_game_name(grids[i].game),
+                 grid_rows(grids[i].grid), cells);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    httpd_resp_sendstr_chunk(req, "]}");
+    httpd_resp_sendstr_chunk(req, NULL);
+
+    free(snap);
+    free(json);
+
+    return ESP_OK;
+}
+
+static const httpd_uri_t status_uri = {
+    .uri = "/status",
+    .method = HTTP_GET,
+    .handler = status_get_handler,
+};
+
+#ifdef CONFIG_TRACE
+// binary dump of the trace ring (see trace.h), for host/trace2perfetto.py
+static esp_err_t trace_get_handler(httpd_req_t *req)
+{
+    size_t len = trace_dump_size();
+    void *buf = malloc(len);
+
+    if (buf == NULL)
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "out of memory");
+
+    len = trace_copy(buf, len);
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_send(req, buf, len);
+    free(buf);
+
+    return ESP_OK;
+}
+
+static const httpd_uri_t trace_uri = {
+    .uri = "/trace",
+    .method = HTTP_GET,
+    .handler = trace_get_handler,
+};
+#endif
+
+void status_server_init(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    httpd_handle_t server = NULL;
+
+    config.server_port = CONFIG_STATUS_SERVER_PORT;
+    config.task_priority = STATUS_SERVER_TASK_PRIORITY;
+
+    if (httpd_start(&server, &config) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "cannot start status server");
+        return;
+    }
+    httpd_register_uri_handler(server, &status_uri);
+#ifdef CONFIG_TRACE
+    httpd_register_uri_handler(server, &trace_uri);
+#endif
+
+    ESP_LOGI(TAG, "status server listening on port %d", config.server_port);
+}
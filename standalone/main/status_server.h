@@ -0,0 +1,17 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __STATUS_SERVER_H__
+#define __STATUS_SERVER_H__
+
+// start the HTTP server exposing GET /status (JSON)
+void status_server_init(void);
+
+#endif /* __STATUS_SERVER_H__ **/
@@ -0,0 +1,140 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "mbedtls/base64.h"
+
+#define TRACE_LEN CONFIG_TRACE_LEN
+#define TRACE_MASK (TRACE_LEN - 1)
+
+_Static_assert((TRACE_LEN & TRACE_MASK) == 0, "CONFIG_TRACE_LEN must be a power of two");
+
+// writers claim a slot with a single atomic increment; the ring overwrites
+// the oldest events, and writers drop their events while it is being copied
+static trace_event_t ring[TRACE_LEN];
+static atomic_uint head;
+static atomic_int copying;
+
+static TaskHandle_t dump_task;
+
+// per task, so the parser and the renderer can each stamp their own record
+static __thread uint16_t current_record;
+
+void trace_set_record(uint16_t record)
+{
+    current_record = record;
+}
+
+void trace_event_id(trace_stage_t stage, trace_phase_t phase, uint16_t record)
+{
+    trace_event_t *e;
+
+    if (atomic_load_explicit(&copying, memory_order_relaxed))
+        return;
+
+    e = &ring[atomic_fetch_add_explicit(&head, 1, memory_order_relaxed) & TRACE_MASK];
+    e->ts_us = (uint32_t)esp_timer_get_time();
+    e->record = record;
+    e->stage = stage;
+    e->phase = phase;
+}
+
+void trace_event(trace_stage_t stage, trace_phase_t phase)
+{
+    trace_event_id(stage, phase, current_record);
+}
+
+size_t trace_dump_size(void)
+{
+    return sizeof(trace_header_t) + sizeof(ring);
+}
+
+size_t trace_copy(void *buf, size_t len)
+{
+    trace_header_t *hdr = buf;
+    trace_event_t *events = (trace_event_t *)(hdr + 1);
+    unsigned int h, n, i;
+
+    if (len < sizeof(trace_header_t))
+        return 0;
+
+    atomic_store(&copying, 1);
+
+    h = atomic_load(&head);
+    n = h < TRACE_LEN ? h : TRACE_LEN;
+    if (n > (len - sizeof(trace_header_t)) / sizeof(trace_event_t))
+        n = (len - sizeof(trace_header_t)) / sizeof(trace_event_t);
+    for (i = 0; i < n; i++)
+        events[i] = ring[(h - n + i) & TRACE_MASK];
+
+    atomic_store(&copying, 0);
+
+    memcpy(hdr->magic, TRACE_MAGIC, sizeof(hdr->magic));
+    hdr->version = TRACE_VERSION;
+    hdr->event_size = sizeof(trace_event_t);
+    hdr->count = n;
+
+    return sizeof(trace_header_t) + n * sizeof(trace_event_t);
+}
+
+static void trace_dump_task(void *pvParameters)
+{
+    unsigned char line[68];
+    uint8_t *buf;
+    size_t len, i, olen;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // only while dumping: the copy is as large as the ring
+        buf = malloc(trace_dump_size());
+        if (buf == NULL)
+        {
+            ESP_LOGW(TAG, "no memory for the trace dump");
+            continue;
+        }
+        len = trace_copy(buf, trace_dump_size());
+
+        // the console is a text channel (and may translate line endings), hence base64
+        printf("TRACE BEGIN %u\n", (unsigned)len);
+        for (i = 0; i < len; i += 48)
+        {
+            mbedtls_base64_encode(line, sizeof(line), &olen, buf + i, len - i < 48 ? len - i : 48);
+            printf("TRACE:%.*s\n", (int)olen, line);
+        }
+        printf("TRACE END\n");
+        fflush(stdout);
+        free(buf);
+    }
+}
+
+void trace_init(void)
+{
+    // lowest priority above idle, like the tweet log
+    xTaskCreate(&trace_dump_task, "trace_dump", TRACE_DUMP_STACK_SIZE, NULL, 1, &dump_task);
+}
+
+void trace_dump(void)
+{
+    if (dump_task != NULL)
+        xTaskNotifyGive(dump_task);
+}
@@ -0,0 +1,89 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// pipeline stages, in processing order
+typedef enum
+{
+    TRACE_TLS_READ, // mbedtls_ssl_read() returned data (record = number of bytes)
+    TRACE_FRAME,    // record split off the stream
+    TRACE_PARSE,    // lwjson_parse()
+    TRACE_TAG,      // tweet_tagged()
+    TRACE_GRID,     // gridscan()
+    TRACE_RENDER,   // ledmatrix_update() / ledmatrix_show_board()
+    TRACE_REFRESH,  // LED strip refresh (its end is when the grid is visible)
+    TRACE_STAGE_NUM,
+} trace_stage_t;
+
+typedef enum
+{
+    TRACE_BEGIN,
+    TRACE_END,
+    TRACE_INSTANT,
+} trace_phase_t;
+
+// one trace event, 8 bytes
+typedef struct __attribute__((packed))
+{
+    uint32_t ts_us;  // esp_timer time, truncated to 32 bits
+    uint16_t record; // record ID (see trace_stage_t for exceptions)
+    uint8_t stage;
+    uint8_t phase;
+} trace_event_t;
+
+// dump format: header followed by count events, oldest first, little endian
+#define TRACE_MAGIC "WTRC"
+#define TRACE_VERSION 1
+
+typedef struct __attribute__((packed))
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t event_size;
+    uint32_t count;
+} trace_header_t;
+
+#ifdef CONFIG_TRACE
+
+#define TRACE_DUMP_STACK_SIZE 2048
+
+void trace_init(void);
+
+// record ID stamped on events of the calling task that don't pass one explicitly
+void trace_set_record(uint16_t record);
+
+// lock-free, safe from any task
+void trace_event(trace_stage_t stage, trace_phase_t phase);
+void trace_event_id(trace_stage_t stage, trace_phase_t phase, uint16_t record);
+
+// copy the ring (header + events, oldest first) into buf, returns bytes written
+size_t trace_copy(void *buf, size_t len);
+size_t trace_dump_size(void);
+
+// write the ring to the console, base64 encoded on "TRACE:" lines; returns
+// right away, the copy and the output are left to a low priority task
+void trace_dump(void);
+
+#else
+
+#define trace_init()
+#define trace_set_record(record)
+#define trace_event(stage, phase)
+#define trace_event_id(stage, phase, record)
+#define trace_dump()
+
+#endif /* CONFIG_TRACE */
+
+#endif /* __TRACE_H__ **/
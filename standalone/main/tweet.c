@@ -0,0 +1,85 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "tweet.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int tweet_tagged(lwjson_t *json, const char *tag)
+{
+    lwjson_token_t *t, *u, *v;
+    char *value;
+
+    t = (lwjson_token_t *)lwjson_find(json, "matching_rules");
+    if (t == NULL || t->type != LWJSON_TYPE_ARRAY)
+        return 0;
+
+    // loop over matched rules
+    for (u = (lwjson_token_t *)lwjson_get_first_child(t); u != NULL; u = u->next)
+    {
+        v = (lwjson_token_t *)lwjson_find_ex(json, u, "tag");
+        if (v == NULL || v->type != LWJSON_TYPE_STRING)
+            return 0;
+
+        value = (char *)v->u.str.token_value;
+        value[v->u.str.token_value_len] = 0;
+        if (strcmp(value, tag) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+char *tweet_text(lwjson_t *json)
+{
+    lwjson_token_t *t = (lwjson_token_t *)lwjson_find(json, "data.text");
+    char *text;
+
+    if (t == NULL || t->type != LWJSON_TYPE_STRING)
+        return NULL;
+
+    text = (char *)t->u.str.token_value;
+    text[t->u.str.token_value_len] = 0;
+
+    return text;
+}
+
+// "2022-02-01T12:34:56.000Z" to ms since the epoch, 0 if malformed
+static int64_t parse_created_at(const char *s)
+{
+    int y, mo, d, h, mi, sec, ms = 0;
+    int64_t era, yoe, doy, doe, days;
+
+    if (sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d", &y, &mo, &d, &h, &mi, &sec) != 6)
+        return 0;
+    if (s[19] == '.')
+        sscanf(s + 20, "%3d", &ms);
+
+    // days since 1970-01-01 in the proleptic Gregorian calendar
+    y -= mo <= 2;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = era * 146097 + doe - 719468;
+
+    return (((days * 24 + h) * 60 + mi) * 60 + sec) * 1000 + ms;
+}
+
+int64_t tweet_created_at(lwjson_t *json)
+{
+    lwjson_token_t *t = (lwjson_token_t *)lwjson_find(json, "data.created_at");
+
+    if (t == NULL || t->type != LWJSON_TYPE_STRING || t->u.str.token_value_len < 19)
+        return 0;
+
+    return parse_created_at(t->u.str.token_value);
+}
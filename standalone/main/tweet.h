@@ -0,0 +1,32 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __TWEET_H__
+#define __TWEET_H__
+
+#include <stdint.h>
+
+#include "lwjson/lwjson.h"
+
+// fields of a filtered stream record, once parsed with lwjson_parse
+// (plain C, shared by the parser task and the host tools; the strings
+// returned are terminated in place, in the record's buffer)
+
+// returns 1 if one of the matched rules is tagged with tag
+int tweet_tagged(lwjson_t *json, const char *tag);
+
+// the tweet's text (JSON string contents, escapes included), NULL if missing
+char *tweet_text(lwjson_t *json);
+
+// tweet creation time (requested with tweet.fields=created_at), ms since
+// the epoch, 0 if missing
+int64_t tweet_created_at(lwjson_t *json);
+
+#endif /* __TWEET_H__ **/
@@ -0,0 +1,86 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "main.h"
+#include "tweetlog.h"
+#include "metrics.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+
+#ifndef CONFIG_TWEETLOG_OFF
+
+static RingbufHandle_t log_buf;
+
+static void enqueue(const char *s)
+{
+    // never wait: a full buffer means the console can't keep up
+    if (log_buf == NULL || xRingbufferSend(log_buf, s, strlen(s) + 1, 0) != pdTRUE)
+        metrics_inc(METRIC_LOG_DROPPED);
+}
+
+static void tweetlog_task(void *pvParameters)
+{
+    size_t len;
+    char *item;
+
+    while (1)
+    {
+        item = xRingbufferReceive(log_buf, &len, portMAX_DELAY);
+        if (item == NULL)
+            continue;
+
+        printf("%s\r\n", item);
+        vRingbufferReturnItem(log_buf, item);
+    }
+}
+
+void tweetlog_init(void)
+{
+    log_buf = xRingbufferCreate(CONFIG_TWEETLOG_BUF_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (log_buf == NULL)
+    {
+        ESP_LOGE(TAG, "cannot allocate tweet log buffer, logging disabled");
+        return;
+    }
+
+    // lowest priority above idle: printing only happens when nothing else runs
+    xTaskCreate(&tweetlog_task, "tweetlog", TWEETLOG_STACK_SIZE, NULL, 1, NULL);
+}
+
+#else
+
+void tweetlog_init(void)
+{
+}
+
+#endif /* CONFIG_TWEETLOG_OFF */
+
+void tweetlog_record(const char *buf)
+{
+#ifdef CONFIG_TWEETLOG_EVERY_N
+    static unsigned int n;
+
+    if (n++ % CONFIG_TWEETLOG_N == 0)
+        enqueue(buf);
+#endif
+}
+
+void tweetlog_wordle(const char *text)
+{
+#ifdef CONFIG_TWEETLOG_WORDLE
+    enqueue(text);
+#endif
+}
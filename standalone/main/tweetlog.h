@@ -0,0 +1,29 @@
+/*
+    Wordle Device for the ESP32C3 RGB development board
+
+    To the extent possible under law, the author(s) have dedicated all copyright
+    and related and neighboring rights to this software to the public domain worldwide.
+    This software is distributed without any warranty.
+    You should have received a copy of the CC0 Public Domain Dedication along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef __TWEETLOG_H__
+#define __TWEETLOG_H__
+
+// Asynchronous console log of incoming records. The parser only enqueues
+// (never blocks, lines that don't fit are dropped and counted), and a low
+// priority task prints them. What gets logged depends on the configuration:
+// every Nth raw record, only the text of Wordle tweets, or nothing.
+
+#define TWEETLOG_STACK_SIZE 2048
+
+void tweetlog_init(void);
+
+// raw JSON record, before parsing (logged in "every Nth record" mode)
+void tweetlog_record(const char *buf);
+
+// text of a tweet containing a Wordle (logged in "Wordle tweets" mode)
+void tweetlog_wordle(const char *text);
+
+#endif /* __TWEETLOG_H__ **/
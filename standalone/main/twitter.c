@@ -14,14 +14,24 @@
 
 #include "main.h"
 #include "twitter.h"
-#include "ledmatrix.h"
+#include "indicator.h"
+#include "wifi.h"
+#include "metrics.h"
+#include "trace.h"
+#include "capture.h"
 
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/stream_buffer.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
 
 #include "mbedtls/platform.h"
 #include "mbedtls/net_sockets.h"
@@ -34,7 +44,7 @@
 #define BEARER_TOKEN CONFIG_TWITTER_BEARER_TOKEN
 #define API_SERVER "api.twitter.com"
 #define HTTPS_PORT "443"
-#define API_STREAM_URL "https://api.twitter.com/2/tweets/search/stream"
+#define API_STREAM_URL "https://api.twitter.com/2/tweets/search/stream?tweet.fields=created_at"
 #define API_STREAM_RULES_URL "https://api.twitter.com/2/tweets/search/stream/rules"
 
 // streaming API request
@@ -44,14 +54,102 @@ static const char *REQUEST_STREAM = "GET " API_STREAM_URL " HTTP/1.0\r\n"
                                     "Authorization: Bearer " BEARER_TOKEN "\r\n"
                                     "\r\n";
 
-// tweet queue
-#define STREAM_BUF_SIZE 1024
-StreamBufferHandle_t stream_buf;
+// stream ring, and when the parser is woken up
+#define STREAM_BUF_SIZE CONFIG_STREAM_BUF_SIZE
+#ifdef CONFIG_STREAM_WAKE_BYTES
+#define STREAM_WAKE BYTERING_WAKE_BYTES
+#define STREAM_WAKE_THRESHOLD CONFIG_STREAM_WAKE_THRESHOLD
+#else
+#define STREAM_WAKE BYTERING_WAKE_NEWLINE
+#define STREAM_WAKE_THRESHOLD 0
+#endif
+bytering_t *stream_ring;
+
+// largest TLS read, straight into the stream ring
+#define STREAM_READ_BUF_SIZE CONFIG_STREAM_READ_BUF_SIZE
+
+// scratch buffer for messages (on the task's stack)
+#define MSG_BUF_SIZE 128
+
+// API server address, resolved as soon as we get an IP (holds one struct addrinfo *)
+static QueueHandle_t dns_queue;
+
+// how long the first connection waits for the prefetched address
+#define DNS_PREFETCH_WAIT_MS 5000
+
+// socket reads time out periodically so that we notice a lost Wi-Fi connection,
+// and a stream without data (Twitter sends a keep-alive every 20 s) is restarted
+#define STREAM_READ_TIMEOUT_MS 1000
+#define STREAM_STALL_TIMEOUT_MS 60000
+
+static void dns_prefetch_task(void *pvParameters)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+        .ai_protocol = IPPROTO_TCP,
+    };
+    struct addrinfo *res = NULL;
+    int ret;
+
+    ret = getaddrinfo(API_SERVER, HTTPS_PORT, &hints, &res);
+    if (ret != 0 || res == NULL)
+        ESP_LOGW(TAG, "DNS prefetch for %s failed (%d)", API_SERVER, ret);
+    else if (xQueueSend(dns_queue, &res, 0) != pdPASS)
+        freeaddrinfo(res); // a previous result hasn't been used yet
+
+    vTaskDelete(NULL);
+}
+
+static void dns_prefetch_start(void)
+{
+    xTaskCreate(&dns_prefetch_task, "dns_prefetch", 3072, NULL, 6, NULL);
+}
+
+static void got_ip_handler(void *arg, esp_event_base_t event_base,
+                           int32_t event_id, void *event_data)
+{
+    dns_prefetch_start();
+}
+
+// connect to the API server, using the prefetched address if there is one
+static int api_connect(mbedtls_net_context *server_fd, TickType_t dns_wait)
+{
+    struct addrinfo *res = NULL, *cur;
+    int fd, ret = MBEDTLS_ERR_NET_CONNECT_FAILED;
+
+    if (xQueueReceive(dns_queue, &res, dns_wait) != pdPASS || res == NULL)
+        return mbedtls_net_connect(server_fd, API_SERVER, HTTPS_PORT, MBEDTLS_NET_PROTO_TCP);
+
+    for (cur = res; cur != NULL; cur = cur->ai_next)
+    {
+        fd = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+        if (fd < 0)
+        {
+            ret = MBEDTLS_ERR_NET_SOCKET_FAILED;
+            continue;
+        }
+        if (connect(fd, cur->ai_addr, cur->ai_addrlen) == 0)
+        {
+            server_fd->fd = fd;
+            ret = 0;
+            break;
+        }
+        close(fd);
+        ret = MBEDTLS_ERR_NET_CONNECT_FAILED;
+    }
+    freeaddrinfo(res);
+
+    return ret;
+}
 
 static void https_stream_task(void *pvParameters)
 {
-    char buf[512];
-    int ret, flags, len;
+    char buf[MSG_BUF_SIZE];
+    uint8_t *span;
+    int ret, flags, len, idle_ms;
+    int64_t handshake_deadline;
+    TickType_t dns_wait = pdMS_TO_TICKS(DNS_PREFETCH_WAIT_MS);
 
     mbedtls_entropy_context entropy;
     mbedtls_ctr_drbg_context ctr_drbg;
@@ -103,6 +201,7 @@ static void https_stream_task(void *pvParameters)
     mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
     mbedtls_ssl_conf_ca_chain(&conf, &cacert, NULL);
     mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+    mbedtls_ssl_conf_read_timeout(&conf, STREAM_READ_TIMEOUT_MS);
 
     if ((ret = mbedtls_ssl_setup(&ssl, &conf)) != 0)
     {
@@ -110,13 +209,21 @@ static void https_stream_task(void *pvParameters)
         goto exit;
     }
 
+    ESP_LOGI(TAG, "TLS context ready, waiting for network...");
+
     while (1)
     {
+        wifi_wait_connected(portMAX_DELAY);
+
+        indicator_set(INDICATOR_HANDSHAKE);
         mbedtls_net_init(&server_fd);
 
         ESP_LOGI(TAG, "Connecting to %s:%s...", API_SERVER, HTTPS_PORT);
 
-        if ((ret = mbedtls_net_connect(&server_fd, API_SERVER, HTTPS_PORT, MBEDTLS_NET_PROTO_TCP)) != 0)
+        // only the first connection waits for the prefetch, later ones use it if ready
+        ret = api_connect(&server_fd, dns_wait);
+        dns_wait = 0;
+        if (ret != 0)
         {
             ESP_LOGE(TAG, "mbedtls_net_connect returned -%x", -ret);
             goto exit;
@@ -124,12 +231,22 @@ static void https_stream_task(void *pvParameters)
 
         ESP_LOGI(TAG, "Connected.");
 
-        mbedtls_ssl_set_bio(&ssl, &server_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
+        mbedtls_ssl_set_bio(&ssl, &server_fd, mbedtls_net_send, NULL, mbedtls_net_recv_timeout);
 
         ESP_LOGI(TAG, "Performing the SSL/TLS handshake...");
 
+        // a server that accepts the connection but never completes the
+        // handshake is given up on like a stalled stream
+        handshake_deadline = esp_timer_get_time() + (int64_t)STREAM_STALL_TIMEOUT_MS * 1000;
         while ((ret = mbedtls_ssl_handshake(&ssl)) != 0)
         {
+            if (esp_timer_get_time() >= handshake_deadline)
+            {
+                ESP_LOGW(TAG, "no handshake after %d s, reconnecting", STREAM_STALL_TIMEOUT_MS / 1000);
+                goto exit;
+            }
+            if (ret == MBEDTLS_ERR_SSL_TIMEOUT && wifi_is_connected())
+                continue;
             if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
             {
                 ESP_LOGE(TAG, "mbedtls_ssl_handshake returned -0x%x", -ret);
@@ -152,6 +269,7 @@ static void https_stream_task(void *pvParameters)
         }
 
         ESP_LOGI(TAG, "Cipher suite is %s", mbedtls_ssl_get_ciphersuite(&ssl));
+        boot_mark(BOOT_MARK_TLS);
 
         ESP_LOGI(TAG, "Writing HTTP request...");
         size_t written_bytes = 0;
@@ -173,16 +291,41 @@ static void https_stream_task(void *pvParameters)
         } while (written_bytes < strlen(REQUEST_STREAM));
 
         ESP_LOGI(TAG, "Reading HTTP response...");
+        idle_ms = 0;
+        capture_chunk(NULL, 0);
 
         do
         {
-            len = sizeof(buf) - 1;
-            bzero(buf, sizeof(buf));
-            ret = mbedtls_ssl_read(&ssl, (unsigned char *)buf, len);
+            // read straight into the stream ring (back-pressure: wait for the parser)
+            int64_t t0 = esp_timer_get_time();
+            len = bytering_reserve_wait(stream_ring, &span, pdMS_TO_TICKS(1000));
+            metrics_observe_us(METRIC_LAT_ENQUEUE, esp_timer_get_time() - t0);
+            if (len == 0)
+                continue;
+            if (len > STREAM_READ_BUF_SIZE)
+                len = STREAM_READ_BUF_SIZE;
+            ret = mbedtls_ssl_read(&ssl, span, len);
 
             if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
                 continue;
 
+            if (ret == MBEDTLS_ERR_SSL_TIMEOUT)
+            {
+                // pause until the Wi-Fi supervisor has reconnected
+                if (!wifi_is_connected())
+                {
+                    ESP_LOGW(TAG, "Wi-Fi connection lost, pausing stream");
+                    break;
+                }
+                idle_ms += STREAM_READ_TIMEOUT_MS;
+                if (idle_ms >= STREAM_STALL_TIMEOUT_MS)
+                {
+                    ESP_LOGW(TAG, "no data for %d s, restarting stream", idle_ms / 1000);
+                    break;
+                }
+                continue;
+            }
+
             if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
             {
                 ret = 0;
@@ -202,15 +345,16 @@ static void https_stream_task(void *pvParameters)
             }
 
             len = ret;
+            idle_ms = 0;
             ESP_LOGD(TAG, "%d bytes read", len);
-
-            // enqueue tweet
-            while (len > 0)
-            {
-                ret = xStreamBufferSend(stream_buf, buf, len, pdMS_TO_TICKS(1000));
-                ESP_LOGD(TAG, "%d bytes enqueued", ret);
-                len -= ret;
-            }
+            indicator_set(INDICATOR_STREAMING);
+            metrics_add(METRIC_BYTES_READ, len);
+            trace_event_id(TRACE_TLS_READ, TRACE_INSTANT, len);
+            capture_chunk(span, len);
+
+            // hand it over to the parser
+            bytering_commit(stream_ring, len);
+            metrics_gauge_max(METRIC_STREAM_BUF_HIGH_WATER, bytering_bytes_available(stream_ring));
         } while (1);
 
         mbedtls_ssl_close_notify(&ssl);
@@ -221,13 +365,22 @@ static void https_stream_task(void *pvParameters)
 
         if (ret != 0)
         {
-            mbedtls_strerror(ret, buf, 100);
+            mbedtls_strerror(ret, buf, sizeof(buf));
             ESP_LOGE(TAG, "Last error was: -0x%x - %s", -ret, buf);
         }
 
         static int request_count;
         ESP_LOGI(TAG, "Completed %d requests", ++request_count);
+        metrics_inc(METRIC_STREAM_RECONNECTS);
+
+        // resume as soon as Wi-Fi is back (the wait at the top of the loop)
+        if (!wifi_is_connected())
+        {
+            ESP_LOGI(TAG, "Waiting for Wi-Fi to reconnect...");
+            continue;
+        }
 
+        indicator_set(INDICATOR_STALLED);
         for (int countdown = 10; countdown >= 0; countdown--)
         {
             ESP_LOGI(TAG, "%d...", countdown);
@@ -237,13 +390,47 @@ static void https_stream_task(void *pvParameters)
     }
 }
 
+#ifdef CONFIG_STREAM_REPLAY
+// stands in for https_stream_task, feeding the parser from the capture partition
+static void replay_task(void *pvParameters)
+{
+    indicator_set(INDICATOR_STREAMING);
+    capture_replay(stream_ring);
+    vTaskDelete(NULL);
+}
+#endif
+
 void twitter_api_init(void)
 {
-    // create stream buffer
-    stream_buf = xStreamBufferCreate(STREAM_BUF_SIZE, 1);
-    if (stream_buf == NULL)
-        blink_red_forever();
+    // resolve the API server as soon as Wi-Fi is up
+    dns_queue = xQueueCreate(1, sizeof(struct addrinfo *));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                        IP_EVENT_STA_GOT_IP,
+                                                        &got_ip_handler,
+                                                        NULL,
+                                                        NULL));
+    // the station may have got its IP before the handler was registered (the
+    // event loop is created by wifi_init); a second prefetch is harmless
+    if (wifi_is_connected())
+        dns_prefetch_start();
+
+    // create stream ring
+    while ((stream_ring = bytering_create(STREAM_BUF_SIZE, STREAM_WAKE, STREAM_WAKE_THRESHOLD,
+                                          pdMS_TO_TICKS(CONFIG_STREAM_WAKE_LINGER_MS))) == NULL)
+    {
+        ESP_LOGE(TAG, "cannot allocate stream ring, retrying");
+        indicator_set(INDICATOR_ERROR);
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    }
 
+#if defined(CONFIG_MEMPROF)
+    // the memory-profile burst is the stream ring's only producer
+    // (see memprof.c), so the stream isn't opened in this mode
+#elif defined(CONFIG_STREAM_REPLAY)
+    xTaskCreate(&replay_task, "stream_replay", CONFIG_STREAM_TASK_STACK_SIZE, NULL, STREAM_TASK_PRIORITY, NULL);
+#else
     // start HTTPS streaming connection to Twitter v2 API
-    xTaskCreate(&https_stream_task, "https_stream_task", 8192, NULL, 5, NULL);
+    // (the task sets up TLS right away, and connects once Wi-Fi is up)
+    xTaskCreate(&https_stream_task, "https_stream_task", CONFIG_STREAM_TASK_STACK_SIZE, NULL, STREAM_TASK_PRIORITY, NULL);
+#endif
 }
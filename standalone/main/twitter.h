@@ -13,11 +13,13 @@
 #ifndef __TWITTER_H__
 #define __TWITTER_H__
 
-#include "freertos/FreeRTOS.h"
-#include "freertos/stream_buffer.h"
+#include "bytering.h"
 
-// tweet queue
-extern StreamBufferHandle_t stream_buf;
+// the parser and the renderer must stay below it (see wordle.c)
+#define STREAM_TASK_PRIORITY 5
+
+// bytes read from the stream, on their way to the parser
+extern bytering_t *stream_ring;
 
 void twitter_api_init(void);
 
@@ -15,6 +15,10 @@
 
 #include "main.h"
 #include "wifi.h"
+#include "indicator.h"
+
+#include <string.h>
+#include <sys/time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -25,6 +29,9 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_tls.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "esp_sntp.h"
 
 // Wi-Fi
 #define ESP_WIFI_SSID CONFIG_ESP_WIFI_SSID
@@ -35,11 +42,255 @@
 static EventGroupHandle_t s_wifi_event_group;
 
 #define WIFI_CONNECTED_BIT 0x01
-#define WIFI_FAIL_BIT 0x02
 
-// number of retries while connecting to Wi-Fi
+// number of retries since the connection was lost
 static int s_retry_num = 0;
 
+// reconnect backoff: doubles with every failed attempt, up to the maximum
+#define WIFI_BACKOFF_MIN_MS 500
+#define WIFI_BACKOFF_MAX_MS 30000
+static esp_timer_handle_t s_retry_timer;
+
+// after this many failed retries the status LED shows an error (retries go on)
+#define WIFI_RETRIES_BEFORE_ERROR 10
+
+// availability bookkeeping, counted from the first connection
+static portMUX_TYPE s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t s_first_connect_us = 0;
+static int64_t s_disconnected_since_us = 0;
+static int64_t s_disconnected_total_us = 0;
+static uint32_t s_disconnects = 0;
+
+// AP parameters cached in NVS for a fast, directed connect on the next boot
+// (the DHCP lease, with ESP_WIFI_REUSE_IP, is kept by lwIP itself)
+#define WIFI_NVS_NAMESPACE "wifi"
+#define WIFI_NVS_KEY_AP "ap"
+
+typedef struct
+{
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_ap_cache_t;
+
+// directed connects that may fail in a row (e.g. the AP was busy) before the
+// cache is dropped for a full scan
+#define WIFI_FAST_CONNECT_ATTEMPTS 3
+
+// what the NVS task is woken up for (notification bits)
+#define WIFI_NVS_STORE 1
+#define WIFI_NVS_ERASE 2
+
+static wifi_config_t s_wifi_config = {
+    .sta = {
+        .ssid = ESP_WIFI_SSID,
+        .password = ESP_WIFI_PASS,
+        .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+        .pmf_cfg = {
+            .capable = true,
+            .required = false},
+    },
+};
+
+static esp_netif_t *s_sta_netif;
+
+// set while connecting with the cached BSSID/channel, and the failed attempts so far
+static int s_fast_connect = 0;
+static int s_fast_failures = 0;
+
+// writes the AP cache: flash writes can stall, so never on the event loop task
+static TaskHandle_t s_nvs_task;
+
+static int ap_cache_load(wifi_ap_cache_t *cache)
+{
+    nvs_handle_t nvs;
+    size_t len = sizeof(wifi_ap_cache_t);
+    esp_err_t ret;
+
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+        return 0;
+    ret = nvs_get_blob(nvs, WIFI_NVS_KEY_AP, cache, &len);
+    nvs_close(nvs);
+
+    return ret == ESP_OK && len == sizeof(wifi_ap_cache_t);
+}
+
+static void ap_cache_store(const wifi_ap_cache_t *cache)
+{
+    wifi_ap_cache_t old;
+    nvs_handle_t nvs;
+
+    // spare the flash if nothing changed
+    if (ap_cache_load(&old) && memcmp(&old, cache, sizeof(wifi_ap_cache_t)) == 0)
+        return;
+
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+        return;
+    nvs_set_blob(nvs, WIFI_NVS_KEY_AP, cache, sizeof(wifi_ap_cache_t));
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+static void ap_cache_erase(void)
+{
+    nvs_handle_t nvs;
+
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+        return;
+    nvs_erase_key(nvs, WIFI_NVS_KEY_AP);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+// remember the AP we are associated with
+static void ap_cache_update(void)
+{
+    wifi_ap_cache_t cache;
+    wifi_ap_record_t ap;
+
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK)
+        return;
+
+    memset(&cache, 0, sizeof(cache));
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+    cache.channel = ap.primary;
+
+    ap_cache_store(&cache);
+}
+
+static void wifi_nvs_task(void *pvParameters)
+{
+    uint32_t bits;
+
+    while (1)
+    {
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        if (bits & WIFI_NVS_ERASE)
+            ap_cache_erase();
+        else if (bits & WIFI_NVS_STORE)
+            ap_cache_update();
+    }
+}
+
+// configure a directed connect from the cached AP parameters, if any
+static void fast_connect_setup(void)
+{
+    wifi_ap_cache_t cache;
+
+    if (!ap_cache_load(&cache) || cache.channel == 0)
+        return;
+
+    ESP_LOGI(TAG, "fast connect to " MACSTR " on channel %d", MAC2STR(cache.bssid), cache.channel);
+    memcpy(s_wifi_config.sta.bssid, cache.bssid, sizeof(cache.bssid));
+    s_wifi_config.sta.bssid_set = true;
+    s_wifi_config.sta.channel = cache.channel;
+    s_wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    s_fast_connect = 1;
+}
+
+// the cached AP is gone (or changed): forget it and go back to a full scan
+static void fast_connect_fallback(void)
+{
+    ESP_LOGI(TAG, "fast connect failed %d times, falling back to full scan", s_fast_failures);
+    s_fast_connect = 0;
+    xTaskNotify(s_nvs_task, WIFI_NVS_ERASE, eSetBits);
+
+    s_wifi_config.sta.bssid_set = false;
+    s_wifi_config.sta.channel = 0;
+    s_wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config);
+}
+
+// set once the wall clock has been synchronized
+static volatile int s_time_synced = 0;
+
+static void time_sync_cb(struct timeval *tv)
+{
+    ESP_LOGI(TAG, "time synchronized via SNTP");
+    s_time_synced = 1;
+}
+
+// keep the wall clock in sync, to measure how old displayed tweets are
+static void time_sync_start(void)
+{
+    if (sntp_enabled())
+        return;
+
+    ESP_LOGI(TAG, "starting SNTP (%s)", CONFIG_SNTP_SERVER);
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, CONFIG_SNTP_SERVER);
+    sntp_set_time_sync_notification_cb(time_sync_cb);
+    sntp_init();
+}
+
+static void retry_timer_cb(void *arg)
+{
+    esp_wifi_connect();
+}
+
+static void schedule_reconnect(void)
+{
+    int backoff_ms = WIFI_BACKOFF_MIN_MS;
+    int i;
+
+    for (i = 0; i < s_retry_num && backoff_ms < WIFI_BACKOFF_MAX_MS; i++)
+        backoff_ms *= 2;
+    if (backoff_ms > WIFI_BACKOFF_MAX_MS)
+        backoff_ms = WIFI_BACKOFF_MAX_MS;
+    s_retry_num++;
+
+    if (s_retry_num > WIFI_RETRIES_BEFORE_ERROR)
+        indicator_set(INDICATOR_ERROR);
+
+    ESP_LOGI(TAG, "retrying connection to the AP in %d ms (attempt %d)", backoff_ms, s_retry_num);
+    esp_timer_stop(s_retry_timer);
+    esp_timer_start_once(s_retry_timer, (uint64_t)backoff_ms * 1000);
+}
+
+static void connection_lost(void)
+{
+    EventBits_t bits = xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+
+    if (!(bits & WIFI_CONNECTED_BIT))
+        return;
+
+    // we were connected: start counting downtime
+    portENTER_CRITICAL(&s_stats_mux);
+    s_disconnected_since_us = esp_timer_get_time();
+    s_disconnects++;
+    portEXIT_CRITICAL(&s_stats_mux);
+
+    indicator_set(INDICATOR_CONNECTING);
+    ESP_LOGW(TAG, "lost connection to SSID: %s", ESP_WIFI_SSID);
+}
+
+static void connection_up(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t down_us = 0;
+
+    portENTER_CRITICAL(&s_stats_mux);
+    if (s_first_connect_us == 0)
+        s_first_connect_us = now;
+    if (s_disconnected_since_us != 0)
+    {
+        down_us = now - s_disconnected_since_us;
+        s_disconnected_total_us += down_us;
+        s_disconnected_since_us = 0;
+    }
+    portEXIT_CRITICAL(&s_stats_mux);
+
+    if (down_us != 0)
+    {
+        wifi_stats_t stats;
+
+        wifi_get_stats(&stats);
+        ESP_LOGI(TAG, "reconnected after %lld ms (%u disconnects, availability %.3f%%)",
+                 down_us / 1000, (unsigned)stats.disconnects, stats.availability * 100.0);
+    }
+
+    xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+}
+
 static void event_handler(void *arg, esp_event_base_t event_base,
                           int32_t event_id, void *event_data)
 {
@@ -49,68 +300,78 @@ static void event_handler(void *arg, esp_event_base_t event_base,
     }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
     {
-        if (s_retry_num < 10)
+        wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+
+        ESP_LOGI(TAG, "connection to the AP failed (reason %d)", event->reason);
+        connection_lost();
+
+        // a directed connect may fail once in a while: drop the cache only
+        // after a few failures in a row
+        if (s_fast_connect && ++s_fast_failures >= WIFI_FAST_CONNECT_ATTEMPTS)
         {
+            fast_connect_fallback();
             esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "retrying connection to the AP");
         }
         else
-        {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-        }
-        ESP_LOGI(TAG, "connection to the AP failed");
+            schedule_reconnect();
     }
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
     {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
+        ESP_LOGI(TAG, "connected to SSID: %s", ESP_WIFI_SSID);
+        boot_mark(BOOT_MARK_IP);
         s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        s_fast_connect = 0;
+        s_fast_failures = 0;
+#ifdef CONFIG_ESP_WIFI_FAST_RECONNECT
+        xTaskNotify(s_nvs_task, WIFI_NVS_STORE, eSetBits);
+#endif
+        time_sync_start();
+        connection_up();
     }
 }
 
-int wifi_init(void)
+void wifi_init(void)
 {
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = ESP_WIFI_SSID,
-            .password = ESP_WIFI_PASS,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-            .pmf_cfg = {
-                .capable = true,
-                .required = false},
-        },
+    const esp_timer_create_args_t retry_timer_args = {
+        .callback = &retry_timer_cb,
+        .name = "wifi_retry",
     };
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
 
     ESP_LOGI(TAG, "ESP_WIFI_MODE_STA");
 
     s_wifi_event_group = xEventGroupCreate();
+    ESP_ERROR_CHECK(esp_timer_create(&retry_timer_args, &s_retry_timer));
 
     ESP_ERROR_CHECK(esp_netif_init());
 
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    s_sta_netif = esp_netif_create_default_wifi_sta();
+
+#ifdef CONFIG_ESP_WIFI_FAST_RECONNECT
+    xTaskCreate(&wifi_nvs_task, "wifi_nvs", WIFI_NVS_STACK_SIZE, NULL, 1, &s_nvs_task);
+    fast_connect_setup();
+#endif
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
+    // handlers stay registered: connection is completed in the background
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
                                                         &event_handler,
                                                         NULL,
-                                                        &instance_any_id));
+                                                        NULL));
 
     ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
                                                         IP_EVENT_STA_GOT_IP,
                                                         &event_handler,
                                                         NULL,
-                                                        &instance_got_ip));
+                                                        NULL));
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
     esp_err_t ret = tcpip_adapter_set_hostname(TCPIP_ADAPTER_IF_STA, ESP_WIFI_HOSTNAME);
     if (ret != ESP_OK)
@@ -119,34 +380,49 @@ int wifi_init(void)
     }
 
     ESP_LOGI(TAG, "wifi_init_sta finished.");
+}
 
-    /* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
-       number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
+int wifi_wait_connected(TickType_t timeout)
+{
     EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-                                           WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+                                           WIFI_CONNECTED_BIT,
                                            pdFALSE,
                                            pdFALSE,
-                                           portMAX_DELAY);
+                                           timeout);
 
-    /* xEventGroupWaitBits() returns the bits before the call returned, hence we can test which event actually
-       happened. */
-    if (bits & WIFI_CONNECTED_BIT)
-    {
-        ESP_LOGI(TAG, "connected to SSID: %s", ESP_WIFI_SSID);
-    }
-    else if (bits & WIFI_FAIL_BIT)
-    {
-        ESP_LOGI(TAG, "Failed to connect to SSID: %s", ESP_WIFI_SSID);
-    }
-    else
-    {
-        ESP_LOGE(TAG, "UNEXPECTED EVENT");
-    }
+    return (bits & WIFI_CONNECTED_BIT) ? 1 : 0;
+}
 
-    /* The event will not be processed after unregister */
-    ESP_ERROR_CHECK(esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, instance_got_ip));
-    ESP_ERROR_CHECK(esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, instance_any_id));
-    vEventGroupDelete(s_wifi_event_group);
+int wifi_is_connected(void)
+{
+    return (xEventGroupGetBits(s_wifi_event_group) & WIFI_CONNECTED_BIT) ? 1 : 0;
+}
 
-    return (bits & WIFI_CONNECTED_BIT) ? 1 : 0;
+void wifi_get_stats(wifi_stats_t *stats)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t since;
+
+    portENTER_CRITICAL(&s_stats_mux);
+    since = s_first_connect_us ? now - s_first_connect_us : 0;
+    stats->disconnects = s_disconnects;
+    stats->disconnected_us = s_disconnected_total_us;
+    if (s_disconnected_since_us != 0)
+        stats->disconnected_us += now - s_disconnected_since_us;
+    portEXIT_CRITICAL(&s_stats_mux);
+
+    stats->connected = wifi_is_connected();
+    stats->since_first_connect_us = since;
+    stats->availability = since > 0 ? 1.0f - (float)stats->disconnected_us / (float)since : 0.0f;
+}
+
+int64_t wifi_wall_clock_ms(void)
+{
+    struct timeval tv;
+
+    if (!s_time_synced)
+        return 0;
+
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
 }
@@ -13,6 +13,32 @@
 #ifndef __WIFI_H__
 #define __WIFI_H__
 
-int wifi_init(void);
+#include "freertos/FreeRTOS.h"
+
+// the task saving the AP cache to NVS (ESP_WIFI_FAST_RECONNECT)
+#define WIFI_NVS_STACK_SIZE 2560
+
+typedef struct
+{
+    int connected;
+    uint32_t disconnects;           // connection losses since the first connection
+    int64_t since_first_connect_us; // time elapsed since the first connection
+    int64_t disconnected_us;        // total time spent disconnected since then
+    float availability;             // fraction of time connected since then
+} wifi_stats_t;
+
+// start connecting to the configured AP (returns immediately, and keeps the
+// connection up for the lifetime of the application, reconnecting with backoff)
+void wifi_init(void);
+
+// wait until the station has an IP address, returns 0 on timeout
+int wifi_wait_connected(TickType_t timeout);
+int wifi_is_connected(void);
+
+void wifi_get_stats(wifi_stats_t *stats);
+
+// wall-clock time (synchronized via SNTP once connected) in ms since the epoch,
+// 0 until the first synchronization
+int64_t wifi_wall_clock_ms(void);
 
 #endif /* __WIFI_H__ **/
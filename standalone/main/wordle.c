@@ -12,241 +12,479 @@
 
 #include "main.h"
 #include "wordle.h"
+#include "grid.h"
+#include "gridscan.h"
+#include "dedup.h"
+#include "stats.h"
+#include "display.h"
+#include "heatmap.h"
 #include "twitter.h"
 #include "ledmatrix.h"
-
+#include "metrics.h"
+#include "history.h"
+#include "trace.h"
+#include "tweetlog.h"
+#include "wifi.h"
+#include "tweet.h"
+
+#include <stdio.h>
 #include <string.h>
 #include "lwjson/lwjson.h"
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
 
-// buffer holding JSON data
-#define TWEET_BUF_LEN 1024
+// buffer holding JSON data (on the parser task's stack)
+#define TWEET_BUF_LEN CONFIG_TWEET_BUF_LEN
 
 // maximum number of parsed JSON tokens
-#define JSON_MAX_TOKENS 50
+#define JSON_MAX_TOKENS CONFIG_JSON_MAX_TOKENS
 
 // tag used by filtered stream's rule to mark "wordle" tweets
 #define TAG_WORDLE CONFIG_TWITTER_WORDLE_TAG
 
-// JSON parser
-static lwjson_t json_parser;
-static lwjson_token_t tokens[JSON_MAX_TOKENS];
+// minimum time between two trace dumps triggered by slow records
+#define TRACE_DUMP_INTERVAL_US 10000000
 
-static int check_wordle_line(char *p, char *p2, char *buf)
-{
-	uint8_t *s = (uint8_t *)p;
-	int len = p2 - p;
-	int i = 0;
-	int count = 0;
+// below https_stream_task, so that reading the socket always comes first,
+// and the renderer below the parser, so that parsing never waits for the LEDs
+#define PARSER_TASK_PRIORITY CONFIG_PARSER_TASK_PRIORITY
+#define RENDER_TASK_PRIORITY CONFIG_RENDER_TASK_PRIORITY
 
-	while (i < len)
-	{
-		if (s[i] == 0xF0)
-		{ // green or yellow
-			if (i + 4 > len)
-				return 0;
-			if (s[i + 1] != 0x9F || s[i + 2] != 0x9F)
-				return 0;
-			if (s[i + 3] == 0xA9)
-			{ // green
-				if (count < 5)
-					buf[count] = 'G';
-				count++;
-			}
-			else if (s[i + 3] == 0xA8)
-			{ // yellow
-				if (count < 5)
-					buf[count] = 'Y';
-				count++;
-			}
-			else
-				return 0;
-			i += 4;
-		}
-		else if (s[i] == 0xE2)
-		{ // black or white
-			if (i + 3 > len)
-				return 0;
-			if (s[i + 1] != 0xAC)
-				return 0;
-			if (s[i + 2] == 0x9B)
-			{ // black
-				if (count < 5)
-					buf[count] = 'B';
-				count++;
-			}
-			else if (s[i + 2] == 0x9C)
-			{ // white
-				if (count < 5)
-					buf[count] = 'W';
-				count++;
-			}
-			else
-				return 0;
-			i += 3;
-		}
-		else
-			break;
-	}
+_Static_assert(PARSER_TASK_PRIORITY < STREAM_TASK_PRIORITY && RENDER_TASK_PRIORITY < STREAM_TASK_PRIORITY,
+	       "the parser and the renderer must run below the stream task");
 
-	if (count == 5)
-		return 1;
-	else
-		return 0;
-}
+// minimum time each grid stays on the LED matrix
+#define DISPLAY_DWELL_US ((int64_t)CONFIG_DISPLAY_DWELL_MS * 1000)
 
-static int check_wordle(char *s, char *buf)
-{
-	int len = strlen(s);
-	char *p1, *p2;
-	int wordle_lines = 0;
+// multi-grid boards waiting for the renderer (too large for the grid queue),
+// and their free slots; a board without a free slot is dropped
+#define BOARD_POOL_LEN 4
 
-	p1 = s;
-	while (p1 < s + len)
-	{
-		p2 = strstr(p1, "\\n");
-		if (p2 == NULL)
-			p2 = s + len;
-		if (check_wordle_line(p1, p2, buf))
-		{
-			wordle_lines += 1;
-			if (wordle_lines > 6)
-				break;
-			buf += 5;
-		}
-		else if (wordle_lines > 0)
-			break;
+// grids on their way from the parser to the renderer
+static QueueHandle_t grid_queue;
 
-		p1 = p2 + 2;
-	}
+static grid_board_t board_pool[BOARD_POOL_LEN];
+static QueueHandle_t board_free;
 
-	return wordle_lines;
-}
+// JSON parser
+static lwjson_t json_parser;
+static lwjson_token_t tokens[JSON_MAX_TOKENS];
 
-static int tagged_wordle()
+// give back the pool slot of an item's board, once shown or dropped
+static void board_release(const wordle_grid_t *item)
 {
-	lwjson_token_t *t, *u, *v;
-	char *tag;
-	int found_tag = 0;
-
-	t = (lwjson_token_t *)lwjson_find(&json_parser, "matching_rules");
-	if (t == NULL || t->type != LWJSON_TYPE_ARRAY)
-		return 0;
+	uint8_t slot;
 
-	// loop over matched rules
-	for (u = (lwjson_token_t *)lwjson_get_first_child(t); u != NULL; u = u->next)
+	if (item->board != 0)
 	{
-		v = (lwjson_token_t *)lwjson_find_ex(&json_parser, u, "tag");
-		if (v == NULL || v->type != LWJSON_TYPE_STRING)
-			return 0;
-
-		// is rule tagged a TAG_WORDLE ?
-		tag = (char *)v->u.str.token_value;
-		tag[v->u.str.token_value_len] = 0;
-		if (strcmp(tag, TAG_WORDLE) == 0)
-		{
-			found_tag = 1;
-			break;
-		}
+		slot = item->board - 1;
+		xQueueSend(board_free, &slot, 0);
 	}
-
-	return found_tag;
 }
 
-static void process_tweet(char *buf)
+static void process_tweet(char *buf, uint16_t record)
 {
-	char wordle_buf[5 * 6 + 1] = {
-			0,
-	};
+	grid_t grid;
 	int wordle_len;
+	gridscan_t scan;
+	game_t game;
 	char *status_text;
-	int ret, i;
-	lwjson_token_t *t;
+	int ret;
+	int64_t t0, t1;
+	int64_t arrival_ms, created_ms, lag_ms;
+	uint8_t slot;
+	wordle_grid_t item;
+	wordle_header_t header;
 
-	ESP_LOGI(TAG, "got tweet");
-	printf("%s\r\n", buf);
+	ESP_LOGD(TAG, "got tweet");
+	tweetlog_record(buf);
 
 	// parse JSON
+	arrival_ms = wifi_wall_clock_ms();
+	t0 = esp_timer_get_time();
+	trace_event(TRACE_PARSE, TRACE_BEGIN);
 	ret = lwjson_parse(&json_parser, buf);
+	trace_event(TRACE_PARSE, TRACE_END);
+	t1 = esp_timer_get_time();
+	metrics_observe_us(METRIC_LAT_PARSE, t1 - t0);
 	if (ret != lwjsonOK)
 	{
 		ESP_LOGI(TAG, "cannot parse JSON (%d)", ret);
+		metrics_inc(METRIC_JSON_PARSE_FAILED);
 		return;
 	}
 
 	// check that one matched rule is tagged as "wordle"
-	if (!tagged_wordle())
+	trace_event(TRACE_TAG, TRACE_BEGIN);
+	ret = tweet_tagged(&json_parser, TAG_WORDLE);
+	trace_event(TRACE_TAG, TRACE_END);
+	if (!ret)
 	{
 		ESP_LOGI(TAG, "not tagged as \"%s\"", TAG_WORDLE);
+		metrics_inc(METRIC_UNTAGGED);
 		return;
 	}
 
 	// extract tweet message
-	t = (lwjson_token_t *)lwjson_find(&json_parser, "data.text");
-	if (t == NULL || t->type != LWJSON_TYPE_STRING)
+	status_text = tweet_text(&json_parser);
+	if (status_text == NULL)
 	{
 		ESP_LOGI(TAG, "invalid JSON");
+		metrics_inc(METRIC_NOT_WORDLE);
 		return;
 	}
-	status_text = (char *)t->u.str.token_value;
-	status_text[t->u.str.token_value_len] = 0;
 
-	// check whether it containts a wordle
-	wordle_len = check_wordle(status_text, wordle_buf);
+	created_ms = tweet_created_at(&json_parser);
 
-	if (wordle_len == 0 || wordle_len > 5) // (we can't visualize 6-line wordles)
+	// check whether it contains the grids of a known game
+	trace_event(TRACE_GRID, TRACE_BEGIN);
+	game = gridscan(status_text, &scan);
+	trace_event(TRACE_GRID, TRACE_END);
+
+	if (game == GAME_NONE)
+	{
+		metrics_inc(METRIC_NOT_WORDLE);
 		return;
+	}
+	ESP_LOGD(TAG, "%s: %d grid(s) of %d rows%s", gridscan_game_name(game), scan.board.num_grids, scan.rows,
+			scan.high_contrast ? ", high contrast" : "");
+
+	// single grids feed the aggregators, and are shown only if solved
+	// (multi-grid boards carry on past their solution, so they are shown as they are)
+	if (scan.board.num_grids == 1)
+	{
+		grid = scan.grid;
+		wordle_len = scan.rows;
+
+		heatmap_add(grid);
+
+		// feed the guess distribution (failures included) when header and grid agree
+		if (game == GAME_WORDLE && stats_parse_header(status_text, &header) &&
+				(header.score == 0 ? wordle_len == 6 && !grid_solved(grid) : header.score == wordle_len && grid_solved(grid)))
+			stats_add(&header);
+
+		// check that it ends with "GGGGG"
+		if (!grid_solved(grid))
+		{
+			metrics_inc(METRIC_NOT_WORDLE);
+			return;
+		}
+	}
+	else
+		metrics_inc(METRIC_MULTI_GRID);
 
-	// check that it ends with "GGGGG"
-	for (i = 0; i < 5; i++)
+	tweetlog_wordle(status_text);
+	metrics_observe_us(METRIC_LAT_MATCH, esp_timer_get_time() - t1);
+
+	// hand it over to the renderer
+	item.grid = scan.grid;
+	item.board = 0;
+	if (scan.board.num_grids > 1)
 	{
-		if (wordle_buf[5 * (wordle_len - 1) + i] != 'G')
-			break;
+		if (xQueueReceive(board_free, &slot, 0) != pdPASS)
+		{
+			// renderer is behind on boards: drop this one rather than stall the parser
+			metrics_inc(METRIC_GRIDS_DROPPED);
+			return;
+		}
+		board_pool[slot] = scan.board;
+		item.board = slot + 1;
 	}
-	if (i < 5)
-		return;
+	item.game = game;
+	item.record = record;
+	item.arrival_lag_ms = WORDLE_LAG_UNKNOWN;
+	if (created_ms != 0 && arrival_ms != 0)
+	{
+		lag_ms = arrival_ms - created_ms;
+		item.arrival_lag_ms = lag_ms > INT32_MAX ? INT32_MAX : lag_ms < -INT32_MAX ? -INT32_MAX : lag_ms;
+	}
+	item.parsed_us = (uint32_t)t0;
 
-	wordle_buf[5 * wordle_len] = 0;
-	// printf("%s\r\n", wordle_buf);
+	if (xQueueSend(grid_queue, &item, 0) != pdPASS)
+	{
+		// renderer is behind: drop the oldest grid rather than stall the parser
+		wordle_grid_t old;
 
-	// push it to LED matrix
-	ledmatrix_update(wordle_buf, wordle_len);
+		if (xQueueReceive(grid_queue, &old, 0) == pdPASS)
+			board_release(&old);
+		xQueueSend(grid_queue, &item, 0);
+		metrics_inc(METRIC_GRIDS_DROPPED);
+	}
+	metrics_gauge_max(METRIC_GRID_QUEUE_HIGH_WATER, uxQueueMessagesWaiting(grid_queue));
 }
 
-void wordle(void)
+#ifdef CONFIG_DEDUP
+// what dedup remembers: the grid itself, or all the rows of the board folded into one value
+static grid_t dedup_key(const wordle_grid_t *item)
+{
+	const grid_board_t *board;
+	grid_t key;
+	int g, r;
+
+	if (item->board == 0)
+		return item->grid;
+
+	board = &board_pool[item->board - 1];
+	key = board->num_grids;
+	for (g = 0; g < board->num_grids; g++)
+		for (r = 0; r < board->rows[g]; r++)
+			key = key * 0x9e3779b97f4a7c15ULL + ((grid_t)r << 16 | board->cells[g][r]);
+
+	return key;
+}
+#endif
+
+// push a grid to the LED matrix; held_us is the time it waited in the scheduler
+static void show_grid(const wordle_grid_t *item, int64_t held_us)
+{
+	int64_t t0, t1, record_us;
+
+	trace_set_record(item->record); // (for the refresh events in ledmatrix.c)
+	t0 = esp_timer_get_time();
+	trace_event(TRACE_RENDER, TRACE_BEGIN);
+	if (item->board == 0)
+		ledmatrix_update(item->grid);
+	else
+		ledmatrix_show_board(&board_pool[item->board - 1]);
+	trace_event(TRACE_RENDER, TRACE_END);
+	t1 = esp_timer_get_time();
+	metrics_observe_us(METRIC_LAT_RENDER, t1 - t0);
+	// single grids only: the history is repainted side by side at boot
+	if (item->board == 0)
+		history_add(item->grid, item->game);
+#ifdef CONFIG_DEDUP
+	dedup_check(dedup_key(item), t1);
+#endif
+	metrics_inc(METRIC_FRAMES_RENDERED);
+	record_us = (uint32_t)t1 - item->parsed_us;
+	metrics_observe_us(METRIC_LAT_RECORD, record_us);
+	boot_mark(BOOT_MARK_FIRST_FRAME);
+
+	// end-to-end latency, from publication on Twitter to the LEDs
+	if (item->arrival_lag_ms != WORDLE_LAG_UNKNOWN)
+	{
+		int64_t e2e_ms = item->arrival_lag_ms + record_us / 1000;
+
+		metrics_observe_us(METRIC_LAT_ARRIVAL, (int64_t)item->arrival_lag_ms * 1000);
+		metrics_observe_us(METRIC_LAT_E2E, e2e_ms * 1000);
+		ESP_LOGI(TAG, "publish-to-LED latency: %lld ms", e2e_ms);
+	}
+
+#if defined(CONFIG_TRACE) && CONFIG_TRACE_SLOW_MS > 0
+	// dump the trace ring when a record is slow (not counting the dwell time),
+	// so it can be analyzed end to end
+	static int64_t last_dump;
+	int64_t slow_us = record_us - held_us;
+	if (slow_us > CONFIG_TRACE_SLOW_MS * 1000 && (last_dump == 0 || t1 - last_dump > TRACE_DUMP_INTERVAL_US))
+	{
+		ESP_LOGW(TAG, "slow record (%lld ms), dumping trace", slow_us / 1000);
+		trace_dump();
+		last_dump = t1;
+	}
+#endif
+}
+
+#ifdef CONFIG_DISPLAY_PICK_FEWEST
+// guesses: the rows of the grid, or of the tallest grid of a board
+static int item_rows(const wordle_grid_t *item)
+{
+	const grid_board_t *board;
+	int g, rows = 0;
+
+	if (item->board == 0)
+		return grid_rows(item->grid);
+	board = &board_pool[item->board - 1];
+	for (g = 0; g < board->num_grids; g++)
+		if (board->rows[g] > rows)
+			rows = board->rows[g];
+
+	return rows;
+}
+#endif
+
+// whether a new candidate replaces the current pick; k counts the candidates
+// competing with the pick (all of them, or those with as few guesses)
+static int pick_candidate(const wordle_grid_t *pick, const wordle_grid_t *item, int *k)
+{
+#ifdef CONFIG_DISPLAY_PICK_FEWEST
+	if (item_rows(item) > item_rows(pick))
+		return 0;
+	if (item_rows(item) < item_rows(pick))
+	{
+		*k = 1;
+		return 1;
+	}
+#endif
+	// reservoir sampling: each of the k candidates ends up picked with probability 1/k
+	return esp_random() % ++(*k) == 0;
+}
+
+// render stage: show at most one grid per dwell window, picked among the
+// grids that arrived meanwhile, so the display rate doesn't follow the stream
+static void render_task(void *pvParameters)
+{
+	wordle_grid_t item, pick;
+	int64_t window_end = 0, now, pick_us = 0, next_draw = 0;
+	display_mode_t mode, shown_mode = DISPLAY_GRIDS;
+	TickType_t wait;
+	int n = 0, k = 0;
+
+	while (1)
+	{
+		now = esp_timer_get_time();
+		mode = display_get_mode();
+		if (mode != shown_mode)
+		{
+			ESP_LOGI(TAG, "display mode: %s", display_mode_name(mode));
+			shown_mode = mode;
+			next_draw = 0;
+			if (mode == DISPLAY_GRIDS)
+				ledmatrix_redraw_grids();
+		}
+
+		// other modes: redraw periodically, grids are dropped (aggregators are fed by the parser)
+		if (mode != DISPLAY_GRIDS)
+		{
+			if (now >= next_draw)
+			{
+				display_draw(mode);
+				next_draw = now + DISPLAY_REFRESH_MS * 1000;
+			}
+			if (xQueueReceive(grid_queue, &item, pdMS_TO_TICKS(DISPLAY_REFRESH_MS)) == pdPASS)
+			{
+				board_release(&item);
+				metrics_inc(METRIC_GRIDS_SHED);
+			}
+			if (n > 0)
+				board_release(&pick);
+			metrics_add(METRIC_GRIDS_SHED, n);
+			n = 0;
+			continue;
+		}
+
+		// wait for the end of the window, or for any grid once it's over
+		if (n > 0 && now >= window_end)
+		{
+			show_grid(&pick, now - pick_us);
+			board_release(&pick);
+			metrics_add(METRIC_GRIDS_SHED, n - 1);
+			n = 0;
+			window_end = now + DISPLAY_DWELL_US;
+			continue;
+		}
+		wait = n > 0 ? pdMS_TO_TICKS((window_end - now + 999) / 1000) + 1 : portMAX_DELAY;
+		// (wake up now and then to notice mode changes)
+		if (wait > pdMS_TO_TICKS(DISPLAY_REFRESH_MS))
+			wait = pdMS_TO_TICKS(DISPLAY_REFRESH_MS);
+		if (xQueueReceive(grid_queue, &item, wait) != pdPASS)
+			continue;
+
+#ifdef CONFIG_DEDUP
+		// skip grids shown recently (popular results and retweets repeat a lot)
+		if (dedup_seen(dedup_key(&item), esp_timer_get_time()))
+		{
+			board_release(&item);
+			metrics_inc(METRIC_GRIDS_SUPPRESSED);
+			continue;
+		}
+#endif
+
+		if (n++ == 0)
+			k = 1;
+		if (n == 1 || pick_candidate(&pick, &item, &k))
+		{
+			if (n > 1)
+				board_release(&pick);
+			pick = item;
+			pick_us = esp_timer_get_time();
+		}
+		else
+			board_release(&item);
+	}
+}
+
+// parse stage: split the stream into records and extract grids
+static void parser_task(void *pvParameters)
 {
 	char buf[TWEET_BUF_LEN];
-	char *tweet_buf = buf;
-	int len;
+	char *tweet_buf;
+	int len, held = 0, skipping = 0;
 	char *pos;
+	uint16_t record_id = 0;
 
 	// initialize JSON parser
 	lwjson_init(&json_parser, tokens, LWJSON_ARRAYSIZE(tokens));
 
 	while (1)
 	{
-		// read stream buffer
-		len = xStreamBufferReceive(stream_buf, buf, TWEET_BUF_LEN - 1, portMAX_DELAY);
-		if (len == 0 || buf[0] != '{')
+		// read stream ring after the unterminated tail of the previous read
+		// (whole records, unless configured to wake on a byte count)
+		len = bytering_receive(stream_ring, buf + held, TWEET_BUF_LEN - 1 - held, portMAX_DELAY);
+		if (len == 0)
 			continue;
+		metrics_inc(METRIC_STREAM_WAKEUPS);
+		len += held;
 		buf[len] = 0;
 
 		// one tweet per line
 		tweet_buf = buf;
-		while (len > 0)
+		while ((pos = strchr(tweet_buf, '\n')) != NULL)
 		{
-			pos = strchr(tweet_buf, '\n');
-			if (pos == NULL)
-				pos = buf + TWEET_BUF_LEN - 1;
 			*pos = 0;
 
-			process_tweet(tweet_buf);
-
-			len -= (pos - tweet_buf + 1);
+			// (skip HTTP headers, keep-alive newlines and the end of a dropped record)
+			if (tweet_buf[0] == '{' && !skipping)
+			{
+				metrics_inc(METRIC_RECORDS_FRAMED);
+				trace_set_record(++record_id);
+				trace_event(TRACE_FRAME, TRACE_INSTANT);
+				process_tweet(tweet_buf, record_id);
+			}
+			skipping = 0;
 			tweet_buf = pos + 1;
-		};
+		}
+
+		// keep the start of the next record, unless it can't fit the buffer
+		held = buf + len - tweet_buf;
+		if (held == TWEET_BUF_LEN - 1)
+		{
+			// (once per record, however many buffers it takes to skip)
+			if (!skipping)
+			{
+				ESP_LOGI(TAG, "record longer than %d bytes, dropped", TWEET_BUF_LEN - 1);
+				metrics_inc(METRIC_RECORDS_TOO_LONG);
+			}
+			skipping = 1;
+			held = 0;
+		}
+		else
+			memmove(buf, tweet_buf, held);
 	}
 }
+
+void wordle(void)
+{
+	uint8_t slot;
+
+	grid_queue = xQueueCreate(CONFIG_GRID_QUEUE_LEN, sizeof(wordle_grid_t));
+	board_free = xQueueCreate(BOARD_POOL_LEN, sizeof(uint8_t));
+	ESP_ERROR_CHECK(grid_queue == NULL || board_free == NULL ? ESP_ERR_NO_MEM : ESP_OK);
+	for (slot = 0; slot < BOARD_POOL_LEN; slot++)
+		xQueueSend(board_free, &slot, 0);
+
+	gridscan_init();
+
+	xTaskCreate(&render_task, "renderer", CONFIG_RENDER_TASK_STACK_SIZE, NULL, RENDER_TASK_PRIORITY, NULL);
+	xTaskCreate(&parser_task, "parser", CONFIG_PARSER_TASK_STACK_SIZE, NULL, PARSER_TASK_PRIORITY, NULL);
+}
+
+void wordle_queue_depths(int *stream_bytes, int *grids)
+{
+	*stream_bytes = stream_ring ? bytering_bytes_available(stream_ring) : 0;
+	*grids = grid_queue ? uxQueueMessagesWaiting(grid_queue) : 0;
+}
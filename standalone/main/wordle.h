@@ -13,6 +13,30 @@
 #ifndef __WORDLE_H__
 #define __WORDLE_H__
 
+#include <stdint.h>
+
+#include "grid.h"
+#include "gridscan.h"
+
+// a parsed Wordle (or variant), as queued from the parser to the renderer:
+// one packed grid and a compact header (multi-grid boards wait in a pool,
+// the item only names their slot)
+typedef struct
+{
+	grid_t grid;             // single grid: cells and number of rows (see grid.h)
+	uint8_t board;           // multi-grid result: its board pool slot + 1 (0: single grid)
+	uint8_t game;            // which game the grids come from (game_t)
+	uint16_t record;         // record ID (see trace.h)
+	int32_t arrival_lag_ms;  // tweet creation to parse, wall clock (WORDLE_LAG_UNKNOWN if unknown)
+	uint32_t parsed_us;      // esp_timer time the record was parsed (low 32 bits: differences only)
+} wordle_grid_t;
+
+#define WORDLE_LAG_UNKNOWN INT32_MIN
+
+// start the parser and renderer tasks
 void wordle(void);
 
+// current depth of the pipeline queues
+void wordle_queue_depths(int *stream_bytes, int *grids);
+
 #endif /* __WORDLE_H__ **/
@@ -1,7 +1,8 @@
 #include <Adafruit_NeoPixel.h>
 
 #define LED_PIN 8
-Adafruit_NeoPixel strip = Adafruit_NeoPixel(25, LED_PIN, NEO_GRB + NEO_KHZ800);
+#define NUM_PIXELS 25 // 5x5 matrix
+Adafruit_NeoPixel strip = Adafruit_NeoPixel(NUM_PIXELS, LED_PIN, NEO_GRB + NEO_KHZ800);
 
 int pixel = 0;
 int cmd;
@@ -31,7 +32,7 @@ void loop() {
 
     strip.show();
 
-    if (pixel == 25)
+    if (pixel == NUM_PIXELS)
       pixel = 0;
   }
 }